@@ -85,6 +85,8 @@ enum class FRKey {
 	DOWN,
 	UP,
     ACTION,
+    PROFILE,
+    OVERLAY,
 	COUNT
 };
 
@@ -99,6 +101,21 @@ enum class FRMouseButton {
 
 FRAMEWORK_API bool isButtonPressed(FRMouseButton button);
 
+FRAMEWORK_API bool isHeadless();
+
+// NOTE(mizofix): number of sprites, rects, texts and textures drawn in the current frame
+FRAMEWORK_API unsigned int getDrawCallsCount();
+
+// NOTE(mizofix): while the input is overridden the mouse is read from the state set
+// by the application, not from the device. Keys are changed by events either way, so
+// their state should be set every frame. It's always overridden in the headless mode
+FRAMEWORK_API void overrideInput(bool overridden);
+
+// NOTE(mizofix): input of the headless mode and replays, the input has to be overridden
+FRAMEWORK_API void setKeyState(FRKey key, bool pressed);
+FRAMEWORK_API void setButtonState(FRMouseButton button, bool pressed);
+FRAMEWORK_API void setCursorPos(int x, int y);
+
 
 class FRAMEWORK_API Framework {
 public:
@@ -133,3 +150,8 @@ public:
 
 
 FRAMEWORK_API int run(Framework*);
+
+// NOTE(mizofix): runs the framework without a window, renderer and font: only
+// PreInit(), Init(), Tick() until it returns true and Close() are called. Sprites
+// and text aren't drawn, textures must not be used at all
+FRAMEWORK_API int runHeadless(Framework*);
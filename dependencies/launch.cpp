@@ -8,6 +8,7 @@
 
 #include "inc/Framework.h"
 #include "Assert.h"
+#include "Profiler.h"
 
 
 TTF_Font* g_systemFont;
@@ -15,6 +16,21 @@ SDL_Renderer *g_renderer;
 SDL_Window* g_window;
 int g_width = 800;
 int g_height = 600;
+
+// NOTE(mizofix): in the headless mode there's no window, renderer or font. Textures
+// aren't loaded (animations still are) and input is set by the application
+bool g_headless = false;
+
+// NOTE(mizofix): draw calls of the current frame, sprites out of the screen
+// aren't counted
+unsigned int g_drawCallsCount = 0;
+
+// NOTE(mizofix): mouse state which is set by the application (the headless mode,
+// recording and replaying) instead of the one of the device
+bool g_inputOverridden = false;
+bool g_buttonState[(int)FRMouseButton::COUNT] = {};
+int  g_cursorX = 0;
+int  g_cursorY = 0;
 
 struct {
 
@@ -70,6 +86,10 @@ static void freeTextures() {
 #include <fstream>
 
 static SDL_Texture* loadTexture(const std::string& path) {
+  if(g_headless) {
+    return nullptr;
+  }
+
   auto textIt = loadedTextures.find(path);
   if(textIt != loadedTextures.end()) {
     return textIt->second;
@@ -87,7 +107,7 @@ static SDL_Texture* loadTexture(const std::string& path) {
 static bool parseAnimation(nlohmann::json& parser, Animation& animation) {
 
   SDL_Texture* texture = loadTexture(parser["texture"].get<std::string>());
-  if(texture == nullptr) {
+  if(texture == nullptr && !g_headless) {
     return false;
   }
 
@@ -145,6 +165,10 @@ FRAMEWORK_API void drawRect(int x, int y, int w, int h,
                             int r, int g, int b, int a,
                             float anchorX, float anchorY,
                             bool relativeToCamera) {
+  if(g_headless) {
+    return;
+  }
+
   int relX = x, relY = y;
   if(relativeToCamera) {
     convertToCameraCoordSystem(relX, relY);
@@ -159,6 +183,8 @@ FRAMEWORK_API void drawRect(int x, int y, int w, int h,
   rect.w = w;
   rect.h = h;
 
+  g_drawCallsCount++;
+
   Uint8 pr, pg, pb, pa;
   SDL_GetRenderDrawColor(g_renderer, &pr, &pg, &pb, &pa);
   SDL_SetRenderDrawColor(g_renderer, r, g, b ,a);
@@ -171,6 +197,9 @@ FRAMEWORK_API void drawRect(int x, int y, int w, int h,
 FRAMEWORK_API void drawText(const std::string& text,
                             int x, int y, float anchorX, float anchorY,
                             Uint8 r, Uint8 g, Uint8 b, bool relativeToCamera) {
+  if(g_headless) {
+    return;
+  }
 
   int relX = x, relY = y;
   if(relativeToCamera) {
@@ -197,6 +226,7 @@ FRAMEWORK_API void drawText(const std::string& text,
   dest.h = th;
 
   SDL_RenderCopy(g_renderer, textTexture, NULL, &dest);
+  g_drawCallsCount++;
 
   SDL_DestroyTexture(textTexture);
 
@@ -249,12 +279,23 @@ FRAMEWORK_API void getSpriteSize(Sprite* s, int& w, int &h)
 {
 	SDL_assert(s);
 
+    if(g_headless) {
+      SDL_Rect frame = s->animation.getSourceRect();
+      w = frame.w;
+      h = frame.h;
+      return;
+    }
+
     SDL_QueryTexture(s->animation.texture, NULL, NULL, &w, &h);
 }
 
 FRAMEWORK_API void drawSprite(Sprite* sprite, int x, int y, int alpha,
                               float scale, float angle, bool relativeToCamera)
 {
+    if(g_headless) {
+      return;
+    }
+
 	SDL_assert(g_renderer);
 	SDL_assert(sprite);
 
@@ -281,6 +322,8 @@ FRAMEWORK_API void drawSprite(Sprite* sprite, int x, int y, int alpha,
       return;
     }
 
+    g_drawCallsCount++;
+
     Uint8 previousAlpha;
     SDL_GetTextureAlphaMod(sprite->animation.texture, &previousAlpha);
     SDL_SetTextureAlphaMod(sprite->animation.texture, alpha);
@@ -325,6 +368,12 @@ FRAMEWORK_API bool isAnimationFinished(Sprite* sprite) {
 
 FRAMEWORK_API void getScreenSize(int& w, int &h)
 {
+    if(g_headless) {
+      w = g_width;
+      h = g_height;
+      return;
+    }
+
 	SDL_Rect viewport;
 	SDL_RenderGetViewport(g_renderer, &viewport);
 	w = viewport.w;
@@ -371,10 +420,18 @@ FRAMEWORK_API void drawTestBackground()
 
 FRAMEWORK_API void showCursor(bool bShow)
 {
-	SDL_ShowCursor(bShow?1:0);
+    if(!g_headless) {
+      SDL_ShowCursor(bShow?1:0);
+    }
 }
 
 FRAMEWORK_API void getCursorPos(int* x, int* y) {
+  if(g_inputOverridden) {
+    *x = g_cursorX;
+    *y = g_cursorY;
+    return;
+  }
+
   SDL_GetMouseState(x, y);
 }
 
@@ -390,10 +447,80 @@ FRAMEWORK_API bool isKeyPressed(FRKey key) {
 }
 
 FRAMEWORK_API bool isButtonPressed(FRMouseButton button) {
+  if(g_inputOverridden) {
+    return g_buttonState[(int)button];
+  }
+
   SDL_PumpEvents();
   return SDL_GetMouseState(NULL, NULL) & SDL_BUTTON(int(button) + SDL_BUTTON_LEFT);
 }
 
+FRAMEWORK_API unsigned int getDrawCallsCount() {
+  return g_drawCallsCount;
+}
+
+FRAMEWORK_API bool isHeadless() {
+  return g_headless;
+}
+
+FRAMEWORK_API void overrideInput(bool overridden) {
+  Assert(!g_headless || overridden);
+  g_inputOverridden = overridden;
+}
+
+FRAMEWORK_API void setKeyState(FRKey key, bool pressed) {
+  Assert(g_inputOverridden);
+  GKeyState[(int)key] = pressed;
+}
+
+FRAMEWORK_API void setButtonState(FRMouseButton button, bool pressed) {
+  Assert(g_inputOverridden);
+  g_buttonState[(int)button] = pressed;
+}
+
+FRAMEWORK_API void setCursorPos(int x, int y) {
+  Assert(g_inputOverridden);
+  g_cursorX = x;
+  g_cursorY = y;
+}
+
+FRAMEWORK_API int runHeadless(Framework* framework)
+{
+    for (int i = 0; i < (int)FRKey::COUNT; ++i)
+    {
+        GKeyState[i] = false;
+    }
+
+    g_headless = true;
+    g_inputOverridden = true;
+
+    bool fullscreen;
+    framework->PreInit(g_width, g_height, fullscreen);
+    g_camera.viewportW = g_width;
+    g_camera.viewportH = g_height;
+
+    // NOTE(mizofix): only for getTickCount()
+    if (SDL_Init(SDL_INIT_TIMER) == -1) {
+        fprintf(stderr, "SDL_Init(SDL_INIT_TIMER) failed: %s\n", SDL_GetError());
+        return(2);
+    }
+
+    framework->renderer = nullptr;
+    if (!framework->Init())
+    {
+        fprintf(stderr, "Framework::Init failed\n");
+        SDL_Quit();
+        exit(1);
+    }
+
+    while (!framework->Tick()) { }
+
+    framework->Close();
+
+    SDL_Quit();
+    return(0);
+}
+
 
 FRAMEWORK_API int run(Framework* framework)
 {
@@ -519,6 +646,8 @@ FRAMEWORK_API int run(Framework* framework)
 
         done = 0;
         while ( ! done ) {
+          {
+            PROFILE_ZONE("event_pump");
             while ( SDL_PollEvent(&event) ) {
                 switch (event.type) {
                 case SDL_KEYUP: {
@@ -530,6 +659,8 @@ FRAMEWORK_API int run(Framework* framework)
 
                   switch (event.key.keysym.sym) {
                   case SDLK_r: key_index = int(FRKey::ACTION); break;
+                  case SDLK_p: key_index = int(FRKey::PROFILE); break;
+                  case SDLK_F3: key_index = int(FRKey::OVERLAY); break;
                   case SDLK_RIGHT:
                   case SDLK_LEFT:
                   case SDLK_DOWN:
@@ -555,6 +686,8 @@ FRAMEWORK_API int run(Framework* framework)
 
                   switch (event.key.keysym.sym) {
                   case SDLK_r: key_index = int(FRKey::ACTION); break;
+                  case SDLK_p: key_index = int(FRKey::PROFILE); break;
+                  case SDLK_F3: key_index = int(FRKey::OVERLAY); break;
                   case SDLK_RIGHT:
                   case SDLK_LEFT:
                   case SDLK_DOWN:
@@ -594,6 +727,7 @@ FRAMEWORK_API int run(Framework* framework)
                   break;
                 }
             }
+          }
 
 			SDL_RenderClear(g_renderer);
 
@@ -604,9 +738,13 @@ FRAMEWORK_API int run(Framework* framework)
 			SDL_SetRenderDrawColor(g_renderer, 0xA0, 0xA0, 0xA0, 0xFF);
 			SDL_RenderClear(g_renderer);
 
+			g_drawCallsCount = 0;
 			done |= GFramework->Tick() ? 1 : 0;
-            
+
+          {
+            PROFILE_ZONE("present");
             SDL_RenderPresent(g_renderer);
+          }
 
             SDL_Delay(1);
         }
@@ -682,6 +820,7 @@ void drawTexture(Texture* texture, int x, int y, bool relativeToCamera) {
   dst.y -= int(float(th) * texture->anchorY);
 
   SDL_RenderCopy(g_renderer, texture->texture, NULL, &dst);
+  g_drawCallsCount++;
 
 }
 
@@ -0,0 +1,20 @@
+#ifndef BENCHMARKS_H_INCLUDED
+#define BENCHMARKS_H_INCLUDED
+
+#include <cstddef>
+#include <stdint.h>
+
+// NOTE(mizofix): fills a registry with random entities of the game (mostly zombies,
+// bullets with their trails, a few boxes and a player) and prints the average time
+// of a frame, which walks over the sets of components of the systems, once with
+// Registry::findEntities() and once with queries, for every number of entities
+// (up to 10000)
+void runQueryBenchmark(uint32_t seed);
+
+// NOTE(mizofix): updates 100000 transformations (a step of the motion) with
+// JobSystem::parallelFor() over an array and with Query::parallelForEachChunk()
+// over the chunks of the entities, and prints the average time of an update for
+// every number of threads from 1 to threadsCount (the main one included)
+void runJobsBenchmark(uint32_t seed, std::size_t threadsCount);
+
+#endif
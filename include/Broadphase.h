@@ -0,0 +1,179 @@
+#ifndef BROADPHASE_H_INCLUDED
+#define BROADPHASE_H_INCLUDED
+
+#include "Common.h"
+#include "Narrowphase.h"
+
+#include <vector>
+
+// NOTE(mizofix): bodies are circles, every coordinate lives in its own array, so
+// a walk over them touches only what it needs. Keys tell which body is which
+// between searches, they're small unique numbers (e.g. indices of the entities).
+// Pairs of bodies which can't collide (see CollisionLayers) aren't found
+struct BroadphaseBodies {
+
+  void clear() {
+    x.clear();
+    y.clear();
+    radius.clear();
+    keys.clear();
+    layers.clear();
+    masks.clear();
+  }
+
+  void add(real bodyX, real bodyY, real bodyRadius, uint32_t key,
+           uint32_t layer = CollisionLayers::ALL, uint32_t mask = CollisionLayers::ALL) {
+    x.push_back(bodyX);
+    y.push_back(bodyY);
+    radius.push_back(bodyRadius);
+    keys.push_back(key);
+    layers.push_back(layer);
+    masks.push_back(mask);
+  }
+
+  std::size_t getSize() const {
+    return x.size();
+  }
+
+  std::vector<real>     x;
+  std::vector<real>     y;
+  std::vector<real>     radius;
+  std::vector<uint32_t> keys;
+  std::vector<uint32_t> layers;
+  std::vector<uint32_t> masks;
+};
+
+// NOTE(mizofix): indices of the bodies, a < b
+struct BroadphasePair {
+  uint32_t a;
+  uint32_t b;
+};
+
+// NOTE(mizofix): by the first body, then by the second one
+void sortPairs(std::vector<BroadphasePair>& pairs);
+
+// NOTE(mizofix): finds every pair of overlapping bodies. The order of the pairs
+// depends only on the bodies of this search and of the previous ones. A search
+// only collects candidates (pairs of bodies which may overlap), the distances are
+// tested by the narrowphase (see findContacts()) in batches of candidates
+class Broadphase {
+public:
+
+  Broadphase(): m_pairTestsCount(0) { }
+  virtual ~Broadphase() { }
+
+  virtual void findPairs(const BroadphaseBodies& bodies, std::vector<BroadphasePair>& pairs) = 0;
+
+  // NOTE(mizofix): tests of distances (candidates) during the last search, pairs
+  // which can't collide aren't tested
+  uint64_t getPairTestsCount() const {
+    return m_pairTestsCount;
+  }
+
+protected:
+
+  void addCandidate(uint32_t a, uint32_t b) {
+    m_candidates.push_back((a < b) ? BroadphasePair{a, b} : BroadphasePair{b, a});
+  }
+
+  // NOTE(mizofix): passes the candidates to the narrowphase if there are at least
+  // minCount of them
+  void testCandidates(std::vector<BroadphasePair>& pairs, std::size_t minCount);
+
+  uint64_t                       m_pairTestsCount;
+  std::vector<BroadphasePair>    m_candidates;
+  std::vector<BroadphasePair>    m_contacts;
+
+  // NOTE(mizofix): circles of the bodies of the search, see packCircles()
+  std::vector<NarrowphaseCircle> m_circles;
+};
+
+Broadphase* createBroadphase(BroadphaseType type);
+
+// NOTE(mizofix): the name of the type on the command line
+const char* getBroadphaseName(BroadphaseType type);
+
+// NOTE(mizofix): the smallest cell, so tiny bodies don't make a huge grid
+const static real GRID_MIN_CELL_SIZE = 8.0f;
+
+// NOTE(mizofix): the cell grows if the grid has more cells than that per body
+const static std::size_t GRID_CELLS_PER_BODY = 4;
+
+// NOTE(mizofix): uniform grid, which is rebuilt for every search. The cell is as
+// large as the largest body, a body is put into the cell of its center, so
+// overlapping bodies are at most one cell away from each other. Bodies are sorted
+// by cells (counting sort), then every cell is tested against itself and against
+// half of its neighbours, so every pair of cells is tested once. Bodies which are
+// far from the others make the cells larger (see GRID_CELLS_PER_BODY)
+class GridBroadphase: public Broadphase {
+public:
+
+  virtual void findPairs(const BroadphaseBodies& bodies, std::vector<BroadphasePair>& pairs);
+
+private:
+
+  void addCandidates(uint32_t cellA, uint32_t cellB);
+
+  // NOTE(mizofix): bodies of a cell are [m_cellStarts[cell], m_cellStarts[cell + 1])
+  // of the sorted arrays
+  std::vector<uint32_t> m_cellStarts;
+  std::vector<uint32_t> m_bodyCells;
+
+  std::vector<uint32_t> m_sortedLayers;
+  std::vector<uint32_t> m_sortedMasks;
+  std::vector<uint32_t> m_sortedBodies;
+};
+
+// NOTE(mizofix): the sort falls back from the insertion sort to a full one after
+// that many moves per body
+const static std::size_t SWEEP_MAX_MOVES_PER_BODY = 16;
+
+// NOTE(mizofix): sweep and prune along the axis where the bodies are spread the
+// most. Bodies are sorted by the starts of their intervals on the axis, and every
+// body is tested against the next ones until they start past its end. Only bodies
+// whose intervals on the other axis overlap as well are candidates. The sorted
+// order of the last search is kept by keys, so when bodies barely move between
+// searches it's almost sorted and the insertion sort fixes it in about linear
+// time. New bodies go to the end before the sort. The order is sorted anew when
+// the axis changes
+class SweepAndPruneBroadphase: public Broadphase {
+public:
+
+  SweepAndPruneBroadphase();
+
+  virtual void findPairs(const BroadphaseBodies& bodies, std::vector<BroadphasePair>& pairs);
+
+private:
+
+  struct SweepBody {
+    real     start;
+    real     end;
+    real     other;
+    real     radius;
+    uint32_t layer;
+    uint32_t mask;
+    uint32_t body;
+  };
+
+  void sortBodies(bool sortAnew);
+
+  uint32_t               m_axis;
+
+  // NOTE(mizofix): keys in the sorted order of the last search
+  std::vector<uint32_t>  m_sortedKeys;
+
+  // NOTE(mizofix): bodies of the keys during the search, indexed by keys, and
+  // bodies which are already in the sweep
+  std::vector<uint32_t>  m_keyBodies;
+  std::vector<uint8_t>   m_takenBodies;
+
+  std::vector<SweepBody> m_sweepBodies;
+};
+
+// NOTE(mizofix): moves random bodies around the map for a few searches and prints
+// the number of tests and the average time of every broadphase and of brute
+// force for every number of bodies (up to 20000). Bodies are spread over the whole
+// map in one scene and gather around its center in the other one
+void runBroadphaseBenchmark(real mapWidth, real mapHeight, uint32_t seed);
+
+#endif
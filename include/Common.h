@@ -12,6 +12,13 @@
 #define info(...)
 #endif
 
+// NOTE(mizofix): see Broadphase.h
+enum class BroadphaseType {
+  GRID,
+  SWEEP_AND_PRUNE,
+  COUNT
+};
+
 struct RoundData {
   uint32_t  currentRoundNumber;
   real elapsedTime;
@@ -43,6 +50,41 @@ struct WorldData {
 
   uint32_t zombieCounter;
 
+  // NOTE(mizofix): threads of the job system including the main one, 0 - one per
+  // hardware thread
+  uint32_t threadsCount;
+
+  // NOTE(mizofix): simulation ticks per second
+  uint32_t simulationRate;
+
+  // NOTE(mizofix): number of ticks to simulate without a window, 0 - the game
+  // isn't headless
+  uint32_t headlessTicks;
+
+  // NOTE(mizofix): where the profiler trace is written on [P] and at exit,
+  // nullptr - it's written only on [P] to the default path
+  const char* profilePath;
+
+  // NOTE(mizofix): seed of the random streams (see seedRandom())
+  uint32_t seed;
+
+  // NOTE(mizofix): where the input of the game is recorded and from where it's
+  // replayed, nullptr - it isn't
+  const char* recordPath;
+  const char* replayPath;
+
+  // NOTE(mizofix): where the message stats of every frame are written (CSV),
+  // nullptr - they aren't
+  const char* messageStatsPath;
+
+  BroadphaseType broadphase;
+
+  // NOTE(mizofix): the broadphases (the queries, the jobs) are benchmarked instead
+  // of running the game
+  bool collisionBenchmark;
+  bool queryBenchmark;
+  bool jobsBenchmark;
+
 };
 
 enum class WeaponType {
@@ -79,11 +121,51 @@ struct WeaponData {
 };
 
 
+// NOTE(mizofix): entity is a generational handle. Lower bits are the index of the
+// entity's slot in the registry, higher bits are the generation of the slot, which
+// is bumped each time the slot is freed. So a handle of a dead entity never
+// matches a new entity, which took its slot.
 using Entity = uint32_t;
 
 namespace Constants {
 
   const static Entity INVALID_ENTITY = uint32_t(-1);
 
+  const static uint32_t ENTITY_INDEX_BITS = 20;
+  const static uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+  const static uint32_t ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+
+};
+
+// NOTE(mizofix): every body is on a layer and has a mask of the layers which it
+// collides with. Two bodies collide only if each one is on a layer of the mask of
+// the other, the rest of the pairs are skipped by the broadphase
+namespace CollisionLayers {
+
+  const static uint32_t PLAYER = 1u << 0;
+  const static uint32_t ZOMBIE = 1u << 1;
+  const static uint32_t BULLET = 1u << 2;
+  const static uint32_t PICKUP = 1u << 3;
+  const static uint32_t MELEE  = 1u << 4;
+
+  const static uint32_t ALL = uint32_t(-1);
+
 };
+
+inline bool canCollide(uint32_t layerA, uint32_t maskA, uint32_t layerB, uint32_t maskB) {
+  return (layerA & maskB) != 0 && (layerB & maskA) != 0;
+}
+
+inline uint32_t getEntityIndex(Entity entity) {
+  return entity & Constants::ENTITY_INDEX_MASK;
+}
+
+inline uint32_t getEntityGeneration(Entity entity) {
+  return (entity >> Constants::ENTITY_INDEX_BITS) & Constants::ENTITY_GENERATION_MASK;
+}
+
+inline Entity makeEntity(uint32_t index, uint32_t generation) {
+  return (index & Constants::ENTITY_INDEX_MASK) |
+         ((generation & Constants::ENTITY_GENERATION_MASK) << Constants::ENTITY_INDEX_BITS);
+}
 #endif
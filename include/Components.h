@@ -1,6 +1,7 @@
 #ifndef COMPONENTS_H_INCLUDED
 #define COMPONENTS_H_INCLUDED
 
+#include <cmath>
 #include <vector>
 #include <list>
 
@@ -10,7 +11,9 @@
 
 #include "ecs/Component.h"
 
-struct Model: Component {
+struct Model {
+
+  const static ComponentID ID = ComponentID::Model;
 
  Model(const char* animationName):Model() {
    sprite = createSprite(animationName);
@@ -18,50 +21,81 @@ struct Model: Component {
 
  Model(): sprite(nullptr), alpha(255) { }
 
+ Model(Model&& model): sprite(model.sprite), alpha(model.alpha) {
+   model.sprite = nullptr;
+ }
+
   ~Model() {
     if(sprite != nullptr) {
       destroySprite(sprite);
     }
   }
 
-  virtual ComponentID getID() {
-    return ComponentID::Model;
-  }
-
   Sprite* sprite;
   int     alpha;
 
 };
 
-struct Transformation: Component {
+struct Transformation {
+
+  const static ComponentID ID = ComponentID::Transformation;
+
+ Transformation(): angle(0.0f), scale(1.0f), previousAngle(0.0f), hasPrevious(false) { }
+
+  // NOTE(mizofix): factor is a part of the simulation step passed since the last
+  // tick (see ECSContext::interpolationFactor), entities which didn't live through
+  // a whole tick are drawn as is
+  vec2 getInterpolatedPosition(real factor) const {
+    if(!hasPrevious) {
+      return position;
+    }
+
+    return previousPosition + (position - previousPosition) * factor;
+  }
+
+  real getInterpolatedAngle(real factor) const {
+    if(!hasPrevious) {
+      return angle;
+    }
 
- Transformation(): angle(0.0f), scale(1.0f) { }
+    real difference = std::fmod(angle - previousAngle, 360.0f);
+    if(difference > 180.0f) {
+      difference -= 360.0f;
+    }
+    else if(difference < -180.0f) {
+      difference += 360.0f;
+    }
 
-  virtual ComponentID getID() {
-    return ComponentID::Transformation;
+    return previousAngle + difference * factor;
   }
 
   vec2 position;
   real angle;
   real scale;
+
+  // NOTE(mizofix): state at the start of the current simulation tick, it's saved by
+  // TransformationHistorySystem
+  vec2 previousPosition;
+  real previousAngle;
+  bool hasPrevious;
 };
 
-struct Attributes: Component {
+struct Attributes {
+
+  const static ComponentID ID = ComponentID::Attributes;
 
  Attributes():  damage(0.0f),
+                regenSpeed(0.0f),
                 maxHealth(0.0f),
                 health(0.0f),
                 maxStamina(0.0f),
                 stamina(0.0f),
                 maxSpeed(0.0f),
                 level(1),
+                footprintElapsedTime(0.0f),
                 isDead(false) { }
 
 
-  virtual ComponentID getID() {
-    return ComponentID::Attributes;
-  }
-
   real damage;
 
   real regenSpeed;
@@ -80,13 +114,13 @@ struct Attributes: Component {
   bool isDead;
 };
 
-struct Physics: Component {
+struct Physics {
 
-  Physics(): mass(1.0f), damping(1.0f) { }
+  const static ComponentID ID = ComponentID::Physics;
 
-  ComponentID getID() {
-    return ComponentID::Physics;
-  }
+  Physics(): mass(1.0f), damping(1.0f), maxSpeed(0.0f), size(0.0f),
+             collisionLayer(CollisionLayers::ALL), collisionMask(CollisionLayers::ALL),
+             transition(false), idling(false) { }
 
   // TODO(mizofix): change to MKS system of units
   vec2 acceleration;
@@ -98,6 +132,10 @@ struct Physics: Component {
 
   real size;
 
+  // NOTE(mizofix): see CollisionLayers, a body collides with everything by default
+  uint32_t collisionLayer;
+  uint32_t collisionMask;
+
   // NOTE(mizofix): true if an entity began or stop moving
   // during last frame
   bool transition;
@@ -111,7 +149,11 @@ struct TrailParticle {
   real elapsedTime;
 };
 
-struct Trail: Component {
+struct Trail {
+
+  const static ComponentID ID = ComponentID::Trail;
+
+  Trail(): Trail(Constants::INVALID_ENTITY, 0.0f, 0.0f, 0.0f, 0) { }
 
   Trail(Entity inTarget, real inLifetime,
         real inMaxRandAngle, real inMaxSpeed,
@@ -122,10 +164,6 @@ struct Trail: Component {
                      size(inSize){ }
 
 
-  ComponentID getID() {
-    return ComponentID::Trail;
-  }
-
   Entity target;
 
   real lifetime;
@@ -138,15 +176,15 @@ struct Trail: Component {
   std::list<TrailParticle> particles;
 };
 
-struct Bullet: Component {
+struct Bullet {
+
+  const static ComponentID ID = ComponentID::Bullet;
 
   Bullet(real inDamage = 0.0f, int inDurability = 0): damage(inDamage),
+                                                      lifetime(0.0f),
+                                                      elapsedTime(0.0f),
                                                       durability(inDurability) { }
 
-  ComponentID getID() {
-    return ComponentID::Bullet;
-  }
-
   real damage;
   real lifetime;
   real elapsedTime;
@@ -161,21 +199,33 @@ struct Bullet: Component {
 class StateController;
 
 
-struct Zombie: Component {
+struct Zombie {
 
-  Zombie(): fov(0.0f),
+  const static ComponentID ID = ComponentID::Zombie;
+
+  Zombie(): stateController(nullptr),
+            wanderingElapsedTime(0.0f),
+            fov(0.0f),
             hearingDistance(0.0f),
             attackDistance(0.0f),
             followingDistance(0.0f),
             sawPlayerRecently(false),
             attacking(false) { }
 
-  ~Zombie();
-
-  virtual ComponentID getID() {
-    return ComponentID::Zombie;
+  Zombie(Zombie&& zombie): stateController(zombie.stateController),
+                           wanderingTarget(zombie.wanderingTarget),
+                           wanderingElapsedTime(zombie.wanderingElapsedTime),
+                           fov(zombie.fov),
+                           hearingDistance(zombie.hearingDistance),
+                           attackDistance(zombie.attackDistance),
+                           followingDistance(zombie.followingDistance),
+                           sawPlayerRecently(zombie.sawPlayerRecently),
+                           attacking(zombie.attacking) {
+    zombie.stateController = nullptr;
   }
 
+  ~Zombie();
+
   StateController* stateController;
 
   // NOTE(mizofix): fov stores as a cos value
@@ -192,26 +242,31 @@ struct Zombie: Component {
 
 
 
-struct Player: Component {
+struct Player {
 
-  Player(): stateController(nullptr) { }
-  ~Player();
+  const static ComponentID ID = ComponentID::Player;
+
+  Player(): currentWeaponIndex(0), stateController(nullptr) { }
 
-  ComponentID getID() {
-    return ComponentID::Player;
+  Player(Player&& player): currentWeaponIndex(player.currentWeaponIndex),
+                           weapons(std::move(player.weapons)),
+                           stateController(player.stateController) {
+    player.stateController = nullptr;
   }
 
+  ~Player();
+
   std::size_t             currentWeaponIndex;
   std::vector<WeaponData> weapons;
   StateController*        stateController;
 };
 
 
-struct WeaponBox: Component {
+struct WeaponBox {
 
-  virtual ComponentID getID() {
-    return ComponentID::Weapon;
-  }
+  const static ComponentID ID = ComponentID::Weapon;
+
+  WeaponBox(): type(WeaponType::PISTOL), clips(0) { }
 
   WeaponType type;
   int        clips;
@@ -3,25 +3,21 @@
 
 #include "Common.h"
 #include "Math.h"
-#include <functional>
 
-class Bullet;
-class Zombie;
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 enum class MessageType {
-  BULLET_COLLISION,
-  ZOMBIE_DEAD,
   PLAYER_DEAD,
-  SPAWN_ZOMBIE,
   SPAWN_EFFECT,
-  WEAPON_PICKUP,
-  POWERUP_PICKUP,
   ZOMBIE_ATTACK,
-  CUSTOM_MESSAGE,
 
   // ECS
 
   ECS_ENTITY_DELETE,
+  ECS_ENTITIES_DELETE,
   ECS_ENTITY_CREATED,
 
   // EVENTS
@@ -43,95 +39,318 @@ enum class EffectType {
 
 class Registry;
 
-struct Message {
-  Message(int inType = 0): type(inType) { }
+// NOTE(mizofix): every message is its own struct, TYPE tells which subscribers get it
 
-  int type;
-  union {
+struct PlayerDeadMessage {
+  const static MessageType TYPE = MessageType::PLAYER_DEAD;
+};
+
+struct SpawnEffectMessage {
+  const static MessageType TYPE = MessageType::SPAWN_EFFECT;
 
-    struct {
-      Bullet* blt;
-      Zombie* zombie;
-    } bullet_collision_info;
+  EffectType type;
+  vec2       position;
+  real       scale;
+  real       angle;
+  real       lifetime;
+  bool       fadeOut;
+};
 
-    struct {
+struct ZombieAttackMessage {
+  const static MessageType TYPE = MessageType::ZOMBIE_ATTACK;
+
+  vec2 position;
+  real angle;
+  real damage;
+};
 
-      Zombie* zombie;
+struct EntityDeleteMessage {
+  const static MessageType TYPE = MessageType::ECS_ENTITY_DELETE;
 
-    } dead_zombie_info;
+  Registry* registry;
+  Entity    entity;
+};
 
-    struct {
-      real x;
-      real y;
-      int bloodType;
-    } spawn_blood_info;
+// NOTE(mizofix): entities are valid only during the notification
+struct EntitiesDeleteMessage {
+  const static MessageType TYPE = MessageType::ECS_ENTITIES_DELETE;
 
-    struct {
-      WeaponType weaponType;
-    } weapon_info;
+  Registry*     registry;
+  const Entity* entities;
+  uint32_t      count;
+};
 
-    struct {
-      Registry* registry;
-      Entity entity;
-    } entity_info;
+struct EntityCreatedMessage {
+  const static MessageType TYPE = MessageType::ECS_ENTITY_CREATED;
 
-    struct {
+  Registry* registry;
+  Entity    entity;
+};
 
-      EffectType type;
-      real x;
-      real y;
-      real scale;
-      real angle;
-      real lifetime;
+struct MouseWheelMessage {
+  const static MessageType TYPE = MessageType::ON_MOUSE_WHEEL;
 
-      bool fadeOut;
+  int y;
+};
 
-    } effect_info;
+// NOTE(mizofix): time is the part of the tick when the bodies started to touch.
+// Only bullets are swept, bodies which aren't are tested at the end of the tick,
+// so it's 1 for pairs without bullets. Collisions come in the order of time
+struct CollisionMessage {
+  const static MessageType TYPE = MessageType::ON_COLLISION;
 
-    struct {
-      int y;
+  Entity entityA;
+  Entity entityB;
+  real   time;
+};
 
-    } wheel;
+// NOTE(mizofix): subscribers of a type are kept in an array in the order of
+// subscription and are called with a pointer to the message, nothing is copied or
+// allocated during the notification. A subscriber may not subscribe or unsubscribe
+// to the type of the message which it handles
+using MessageFunction = void(*)(void* owner, const void* message);
 
-    struct {
+// NOTE(mizofix): unsubscribes when it's destroyed or reset
+class Subscription {
+public:
 
-      Entity entityA;
-      Entity entityB;
+  Subscription(): m_type(MessageType::COUNT), m_id(0) { }
+  Subscription(MessageType type, uint32_t id): m_type(type), m_id(id) { }
 
-    } collision_info;
+  Subscription(Subscription&& subscription): m_type(subscription.m_type), m_id(subscription.m_id) {
+    subscription.m_type = MessageType::COUNT;
+  }
 
-    struct {
+  Subscription& operator=(Subscription&& subscription) {
+    if(this != &subscription) {
+      reset();
+      std::swap(m_type, subscription.m_type);
+      std::swap(m_id, subscription.m_id);
+    }
 
-      real x;
-      real y;
-      real angle;
-      real damage;
+    return *this;
+  }
 
+  Subscription(const Subscription&) = delete;
+  Subscription& operator=(const Subscription&) = delete;
+
+  ~Subscription() {
+    reset();
+  }
+
+  void reset();
+
+  bool isActive() const {
+    return m_type != MessageType::COUNT;
+  }
+
+private:
+  MessageType m_type;
+  uint32_t    m_id;
+};
+
+Subscription subscribeToMessage(MessageType type, void* owner, MessageFunction function);
+
+void notifySubscribers(MessageType type, const void* message);
+bool hasSubscribers(MessageType type);
+
+template <typename MessageT>
+void notify(const MessageT& message) {
+  notifySubscribers(MessageT::TYPE, &message);
+}
 
-    } attack_info;
+template <typename T, typename MessageT>
+MessageT getMessageTypeOf(void (T::*)(const MessageT&));
 
-    void* custom_data;
+// NOTE(mizofix): e.g. subscribe<&PlayerSystem::onMouseWheel>(this), the method
+// takes a const reference to the message
+template <auto Method, typename T>
+Subscription subscribe(T* owner) {
+  using MessageT = decltype(getMessageTypeOf(Method));
 
+  MessageFunction function = [](void* owner, const void* message) {
+    (static_cast<T*>(owner)->*Method)(*static_cast<const MessageT*>(message));
   };
 
+  return subscribeToMessage(MessageT::TYPE, owner, function);
+}
+
+// NOTE(mizofix): posted messages aren't handled right away, they're queued for the
+// next tick. Every thread posts into its own buffer of the queue, so posting takes
+// no locks and may happen from any system or job. swapMessageQueues() is called
+// after every tick, it merges the buffers into an array, which consumers walk in
+// their update() during the next tick. Messages are merged in the order of their
+// keys (see getMessageKey()) and then in the posted order, so the result doesn't
+// depend on how threads interleaved. Nothing may be posted during the swap
+class MessageQueueBase {
+public:
+  virtual ~MessageQueueBase() { }
+
+  virtual void swap() = 0;
+  virtual void clear() = 0;
+};
+
+void registerMessageQueue(MessageQueueBase* queue);
+void swapMessageQueues();
+void clearMessageQueues();
+
+// NOTE(mizofix): posted messages are delivered when they're swapped into the array
+// of the last tick
+void countDeliveredMessages(MessageType type, uint64_t count);
+
+// NOTE(mizofix): messages, which a producer (see CommandBuffer::setProducer()) posts
+// from several jobs at once, are told apart by the batch. JobSystem::parallelFor()
+// sets it to the number of the range plus one, jobs keep the batch of the thread
+// which has run them. It's zero outside of parallelFor()
+void setMessageBatch(uint32_t batch);
+uint32_t getMessageBatch();
+
+// NOTE(mizofix): the producer in the high half and the batch in the low one
+uint64_t getMessageKey();
+
+template <typename MessageT>
+class MessageQueue: public MessageQueueBase {
+public:
+
+  MessageQueue() {
+    registerMessageQueue(this);
+  }
+
+  ~MessageQueue() {
+    for(ThreadBuffer* buffer: m_buffers) {
+      delete buffer;
+    }
+  }
+
+  MessageQueue(const MessageQueue&) = delete;
+  MessageQueue& operator=(const MessageQueue&) = delete;
+
+  void push(const MessageT& message) {
+    getThreadBuffer().push_back(PostedMessage{getMessageKey(), message});
+  }
+
+  const MessageT* begin() const {
+    return m_front.data();
+  }
+
+  const MessageT* end() const {
+    return m_front.data() + m_front.size();
+  }
+
+  std::size_t getSize() const {
+    return m_front.size();
+  }
+
+  // NOTE(mizofix): a thread runs the jobs of a producer's batch one after another,
+  // so equal keys come only from one buffer and the stable sort keeps their order
+  virtual void swap() {
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+    m_merged.clear();
+    for(ThreadBuffer* buffer: m_buffers) {
+      m_merged.insert(m_merged.end(), buffer->begin(), buffer->end());
+      buffer->clear();
+    }
+
+    std::stable_sort(m_merged.begin(), m_merged.end(),
+                     [](const PostedMessage& a, const PostedMessage& b) {
+                       return a.key < b.key;
+                     });
+
+    m_front.clear();
+    for(const PostedMessage& posted: m_merged) {
+      m_front.push_back(posted.message);
+    }
+
+    countDeliveredMessages(MessageT::TYPE, m_front.size());
+  }
+
+  virtual void clear() {
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+    m_front.clear();
+    for(ThreadBuffer* buffer: m_buffers) {
+      buffer->clear();
+    }
+  }
+
+private:
+
+  struct PostedMessage {
+    uint64_t key;
+    MessageT message;
+  };
+
+  using ThreadBuffer = std::vector<PostedMessage>;
+
+  // NOTE(mizofix): the buffer is created when the thread posts the type for the
+  // first time, only then the mutex is taken. The queue lives until the end of
+  // the program, so buffers are never deleted before it
+  ThreadBuffer& getThreadBuffer() {
+    static thread_local ThreadBuffer* t_buffer = nullptr;
+    if(t_buffer == nullptr) {
+      t_buffer = new ThreadBuffer();
+
+      std::lock_guard<std::mutex> lock(m_buffersMutex);
+      m_buffers.push_back(t_buffer);
+    }
+
+    return *t_buffer;
+  }
+
+  std::vector<MessageT>      m_front;
+  std::vector<PostedMessage> m_merged;
+
+  std::mutex                 m_buffersMutex;
+  std::vector<ThreadBuffer*> m_buffers;
 };
 
-void addNewMessage(Message message);
-bool pollMessage(Message& message);
-bool peekMessage(Message& message);
-bool hasMessage();
+template <typename MessageT>
+MessageQueue<MessageT>& getMessageQueue() {
+  static MessageQueue<MessageT> queue;
+  return queue;
+}
 
-void notify(Message message);
+// NOTE(mizofix): counts a message, which isn't sent through notifySubscribers()
+void countMessage(MessageType type);
 
-using MessageFunction = std::function<void(Message)>;
-void subscribeToMessage(int type, MessageFunction function);
+template <typename MessageT>
+void post(const MessageT& message) {
+  countMessage(MessageT::TYPE);
+  getMessageQueue<MessageT>().push(message);
+}
 
-template <typename T>
-void registerMethod(int type, void(T::*method)(Message), T* owner) {
-  auto func = std::bind(method, owner, std::placeholders::_1);
-  subscribeToMessage(type, func);
+// NOTE(mizofix): messages posted during the last tick
+template <typename MessageT>
+const MessageQueue<MessageT>& getMessages() {
+  return getMessageQueue<MessageT>();
 }
 
-void clearSubscribers();
+// NOTE(mizofix): emitted  - notified or posted messages
+// delivered - calls of the handlers and posted messages given to the consumers
+// handlersTime - nanoseconds spent in the handlers, time of a notification from a
+// handler is counted by both types
+struct MessageStats {
+  uint64_t emittedCount;
+  uint64_t deliveredCount;
+  uint64_t handlersTime;
+  uint32_t subscribersCount;
+};
+
+// NOTE(mizofix): totals since the start
+MessageStats getMessageStats(int type);
+
+// NOTE(mizofix): takes the stats of the frame (since the last call), has to be
+// called once per frame on the main thread. Emitted messages go to the profiler
+// as counters, and all the stats are written to the stats file if it's open
+void updateMessageFrameStats();
+const MessageStats& getMessageFrameStats(int type);
+
+// NOTE(mizofix): CSV with a line per frame and type, types without messages in
+// the frame are skipped
+bool openMessageStatsFile(const char* path);
+bool closeMessageStatsFile();
+
+const char* getMessageTypeName(int type);
 
 #endif
@@ -0,0 +1,69 @@
+#ifndef NARROWPHASE_H_INCLUDED
+#define NARROWPHASE_H_INCLUDED
+
+#include "Common.h"
+
+#include <vector>
+
+struct BroadphaseBodies;
+struct BroadphasePair;
+
+enum class NarrowphaseType {
+  SCALAR,
+  SSE2,
+  AVX2,
+
+  COUNT
+};
+
+// NOTE(mizofix): the broadphase passes candidates to the narrowphase in batches of
+// that many pairs, so the candidates and the bodies are still in the cache
+const static std::size_t NARROWPHASE_BATCH_SIZE = 1024;
+
+// NOTE(mizofix): whether the CPU can run the type, the scalar one runs anywhere
+bool isNarrowphaseSupported(NarrowphaseType type);
+
+// NOTE(mizofix): the widest supported type, it's picked once on the first call
+NarrowphaseType getBestNarrowphase();
+
+const char* getNarrowphaseName(NarrowphaseType type);
+
+// NOTE(mizofix): a body of the narrowphase, the circle is loaded into a register
+// at once instead of three loads from the arrays of the bodies
+struct alignas(16) NarrowphaseCircle {
+  real x;
+  real y;
+  real radius;
+  real unused;
+};
+
+// NOTE(mizofix): circles of the bodies, in the same order
+void packCircles(const BroadphaseBodies& bodies, std::vector<NarrowphaseCircle>& circles);
+
+// NOTE(mizofix): tests candidate pairs of bodies (indices of the circles) with
+// squared distances, 4 (SSE2) or 8 (AVX2) pairs at once, and writes the
+// overlapping ones to contacts in the order of the candidates. Contacts must have
+// room for all the candidates, the number of contacts is returned. Every type does
+// exactly the same float operations, so contacts don't depend on the type
+std::size_t findContacts(NarrowphaseType type, const NarrowphaseCircle* circles,
+                         const BroadphasePair* candidates, std::size_t candidatesCount,
+                         BroadphasePair* contacts);
+
+inline std::size_t findContacts(const NarrowphaseCircle* circles,
+                                const BroadphasePair* candidates, std::size_t candidatesCount,
+                                BroadphasePair* contacts) {
+  return findContacts(getBestNarrowphase(), circles, candidates, candidatesCount, contacts);
+}
+
+// NOTE(mizofix): a body starts at offset from the other one and moves by motion
+// relative to it during the tick, radius is the sum of their radii. Returns
+// whether they touch during the tick, time is the earliest part of the tick when
+// they do (0 if they overlap from the start)
+bool findTimeOfImpact(const vec2& offset, const vec2& motion, real radius, real& time);
+
+// NOTE(mizofix): tests the same candidates (pairs of nearby bodies, about a half
+// of them overlap) with every supported type and prints the average time per
+// million of pairs
+void runNarrowphaseBenchmark(uint32_t seed);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+#include <stdint.h>
+#include <cstddef>
+
+// NOTE(mizofix): the latest events are kept, older ones are overwritten
+const static std::size_t PROFILER_EVENTS_COUNT = 1 << 16;
+
+// NOTE(mizofix): names and categories have to live until the trace is dumped,
+// use string literals or names from internProfilerName()
+struct ProfilerEvent {
+  const char* name;
+  const char* category;
+
+  // NOTE(mizofix): in nanoseconds since the start of the program
+  uint64_t    start;
+  uint64_t    duration;
+
+  uint32_t    thread;
+
+  // NOTE(mizofix): 'X' - a zone, 'C' - a counter, its value is kept in duration
+  char        phase;
+};
+
+uint64_t getProfilerTime();
+
+// NOTE(mizofix): a copy of the name which lives until the end of the program, the
+// same names share the copy. Names which may be freed (e.g. names of the systems,
+// which are removed when the player dies) have to be interned before recording
+const char* internProfilerName(const char* name);
+
+// NOTE(mizofix): lock-free, may be called from any thread
+void recordProfilerEvent(const char* name, const char* category, uint64_t start, uint64_t end);
+
+// NOTE(mizofix): the trace viewers draw counters as graphs over time
+void recordProfilerCounter(const char* name, const char* category, uint64_t value);
+
+// NOTE(mizofix): writes recorded events in the Chrome trace format (it's opened by
+// about:tracing and Perfetto). Events which are being recorded at the moment are
+// skipped, so it's better to call it between frames
+bool dumpProfilerTrace(const char* path);
+
+// NOTE(mizofix): records an event from the construction to the destruction
+class ProfilerZone {
+public:
+
+  ProfilerZone(const char* name, const char* category = "frame"): m_name(name),
+                                                                 m_category(category),
+                                                                 m_start(getProfilerTime()) { }
+
+  ~ProfilerZone() {
+    recordProfilerEvent(m_name, m_category, m_start, getProfilerTime());
+  }
+
+  ProfilerZone(const ProfilerZone&) = delete;
+  ProfilerZone& operator=(const ProfilerZone&) = delete;
+
+private:
+  const char* m_name;
+  const char* m_category;
+  uint64_t    m_start;
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#define PROFILE_ZONE(...) ProfilerZone PROFILER_CONCAT(profilerZone, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef RANDOM_H_INCLUDED
+#define RANDOM_H_INCLUDED
+
+#include "Math.h"
+
+#include <cstddef>
+#include <stdint.h>
+
+// NOTE(mizofix): PCG32 (XSH RR variant). The state is 16 bytes, a number costs a
+// multiplication and a rotation. Generators with the same seed and different
+// streams give independent sequences. A generator isn't thread-safe, every thread
+// should use its own one
+class Random {
+public:
+
+  Random(uint64_t seed = 0, uint64_t stream = 0) {
+    setSeed(seed, stream);
+  }
+
+  void setSeed(uint64_t seed, uint64_t stream) {
+    m_state = 0;
+    m_increment = (stream << 1) | 1;
+    nextUint();
+    m_state += seed;
+    nextUint();
+  }
+
+  uint32_t nextUint() {
+    uint64_t state = m_state;
+    m_state = state * 6364136223846793005ULL + m_increment;
+
+    uint32_t xorShifted = uint32_t(((state >> 18) ^ state) >> 27);
+    uint32_t rotation = uint32_t(state >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+  }
+
+  // NOTE(mizofix): in [0, bound), the bias is at most bound / 2^32
+  uint32_t nextInt(uint32_t bound) {
+    return uint32_t((uint64_t(nextUint()) * bound) >> 32);
+  }
+
+  // NOTE(mizofix): in [0, 1), 24 bits of a float mantissa
+  real nextReal() {
+    return real(nextUint() >> 8) * (1.0f / 16777216.0f);
+  }
+
+  real nextReal(real start, real end) {
+    return nextReal() * (end - start) + start;
+  }
+
+  // NOTE(mizofix): the same numbers as count calls of nextReal(start, end), but the
+  // state stays in registers
+  void fillReals(real* values, std::size_t count, real start, real end) {
+    Random random = *this;
+    real scale = (end - start) * (1.0f / 16777216.0f);
+    for(std::size_t i = 0; i < count; ++i) {
+      values[i] = real(random.nextUint() >> 8) * scale + start;
+    }
+
+    *this = random;
+  }
+
+private:
+  uint64_t m_state;
+  uint64_t m_increment;
+};
+
+// NOTE(mizofix): every subsystem has its own stream, so the numbers which it gets
+// don't depend on the order in which the others are updated. A stream is used only
+// by its subsystem (Effects - by EffectsSystem, which spawns the posted effects).
+// Code which runs in jobs should make its own generators with makeRandom()
+enum class RandomStream {
+  Plants,
+  Level,
+  Zombies,
+  Effects,
+  Trails,
+  COUNT
+};
+
+// NOTE(mizofix): restarts all the streams, the same seed gives the same game
+void seedRandom(uint64_t seed);
+
+Random& getRandom(RandomStream stream);
+
+// NOTE(mizofix): a generator of the seeded game, which doesn't share numbers with
+// the streams or with generators of other substreams (e.g. chunks of a query)
+Random makeRandom(RandomStream stream, uint64_t substream);
+
+#endif
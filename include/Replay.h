@@ -0,0 +1,94 @@
+#ifndef REPLAY_H_INCLUDED
+#define REPLAY_H_INCLUDED
+
+#include "Common.h"
+
+#include <cstdio>
+#include <stdint.h>
+
+// NOTE(mizofix): a replay is a header and the input of every frame. The game is
+// deterministic for the same settings, seed, frame times and input, so replaying
+// the input reproduces the recorded game. Files are written in the byte order of
+// the machine
+
+// NOTE(mizofix): settings which change the simulation, they replace the given ones
+// when the game is replayed
+struct ReplayHeader {
+  uint32_t seed;
+  uint32_t simulationRate;
+
+  int32_t  windowWidth;
+  int32_t  windowHeight;
+
+  real     mapWidth;
+  real     mapHeight;
+
+  uint32_t numEnemies;
+  uint32_t numPlants;
+
+  real     maxPlayerHealth;
+  real     maxPlayerStamina;
+  real     regenSpeed;
+  real     staminaRegenSpeed;
+
+  uint32_t maxEffectsNumber;
+  uint32_t startRound;
+};
+
+// NOTE(mizofix): keys and buttons are bitmasks of FRKey and FRMouseButton, the wheel
+// is the last scroll of the frame (0 - there's none)
+struct ReplayFrame {
+  real     deltaTime;
+  uint16_t keys;
+  uint8_t  buttons;
+  int8_t   wheel;
+  int16_t  cursorX;
+  int16_t  cursorY;
+};
+
+ReplayHeader makeReplayHeader(const WorldData& data);
+void applyReplayHeader(const ReplayHeader& header, WorldData& data);
+
+class ReplayWriter {
+public:
+
+  ReplayWriter();
+  ~ReplayWriter();
+
+  ReplayWriter(const ReplayWriter&) = delete;
+  ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+  bool open(const char* path, const ReplayHeader& header);
+  bool writeFrame(const ReplayFrame& frame);
+  bool close();
+
+  bool isOpen() const;
+
+private:
+  FILE* m_file;
+};
+
+class ReplayReader {
+public:
+
+  ReplayReader();
+  ~ReplayReader();
+
+  ReplayReader(const ReplayReader&) = delete;
+  ReplayReader& operator=(const ReplayReader&) = delete;
+
+  bool open(const char* path);
+
+  // NOTE(mizofix): returns false at the end of the replay
+  bool readFrame(ReplayFrame& frame);
+  void close();
+
+  bool isOpen() const;
+  const ReplayHeader& getHeader() const;
+
+private:
+  FILE*        m_file;
+  ReplayHeader m_header;
+};
+
+#endif
@@ -4,27 +4,47 @@
 #include "Message.h"
 #include "Common.h"
 #include "Assert.h"
+#include "Broadphase.h"
 #include "json.hpp"
 
 #include "ecs/System.h"
+#include "ecs/SystemManager.h"
 
 #include "Components.h"
 
+#include <array>
 #include <list>
 
-// NOTE(mizofix): current trail system is frame rate dependent,
-// to prevent some bugs we should consider to lock frame rate
-// or find a better way to draw trail (e.g via OpenGL)
+// NOTE(mizofix): saves transformations at the start of each simulation tick, so
+// they can be interpolated when drawn. It has to be updated before anything moves
+class TransformationHistorySystem: public System {
+public:
+  virtual bool init(ECSContext& context);
+  virtual void update(ECSContext& context, real deltaTime);
+
+private:
+  Query* m_transformations;
+};
+
+// NOTE(mizofix): particles are generated once per simulation tick, so trails
+// don't depend on the frame rate anymore
 class TrailSystem: public System {
 public:
 
+  virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
   virtual void draw(ECSContext& context);
 private:
   TrailParticle generateParticle(const vec2& targetVelocity,
                                  const vec2& position,
                                  real maxAngle,
-                                 real maxSpeed);
+                                 real maxSpeed,
+                                 const real* randomValues);
+
+  Query* m_trails;
+
+  // NOTE(mizofix): numbers of the current tick, two per trail
+  std::vector<real> m_randomValues;
 };
 
 class Player;
@@ -33,16 +53,12 @@ class PlayerSystem: public System {
 public:
   virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
+  virtual void draw(ECSContext& context);
 
-  void onWeaponPickup(Message message);
-  //void onPowerupPickup(Message message);
-  void onMouseWheel(Message message);
-
-  void onZombieAttack(Message message);
-  void onCollision(Message message);
+  void onMouseWheel(const MouseWheelMessage& message);
 
 private:
-  void processPlayerCollisions(Registry* registry);
+  void processPlayerCollisions(Registry* registry, CommandBuffer* commands);
 
   void initWeapons(Player* player);
   WeaponData parseWeapon(nlohmann::json& parser);
@@ -52,11 +68,10 @@ private:
 
   void notifyPlayerDead();
 
-  Bitfield m_playerBitfield;
+  Query* m_players;
   int m_lastFrameMouseWheel;
 
-  std::list<Message> m_unprocessedZombieAttacks;
-  std::list<Message> m_unprocessedCollisions;
+  Subscription m_mouseWheelSubscription;
 };
 
 class ZombieSystem: public System {
@@ -64,9 +79,9 @@ public:
   virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
 
-  void onGenerateZombie(Message message);
 private:
-  Bitfield m_zombieComponents;
+  Query* m_zombies;
+  Query* m_players;
 };
 
 
@@ -84,6 +99,10 @@ private:
   real m_elapsedTimeFromLastZombieGeneration;
   real m_elapsedTimeFromLastBoxGeneration;
 
+  Query* m_players;
+  Query* m_zombies;
+  Query* m_weapons;
+
 };
 
 class NotificationSystem {
@@ -96,39 +115,76 @@ public:
 
 class FootprintGenerationSystem: public System {
 public:
+  virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
 
+private:
+  Query* m_walkers;
 };
 
 class ModelRenderingSystem: public System {
 public:
+  virtual bool init(ECSContext& context);
   virtual void draw(ECSContext& context);
+
+private:
+  Query* m_models;
 };
 
 class PhysicsIntegrationSystem: public System {
 public:
+  virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
+
+private:
+  Query* m_bodies;
 };
 
 
-// TODO(mizofix): At least Spatial Partioning optimization (or BSP)
+// NOTE(mizofix): bodies are copied into arrays and the broadphase (see
+// WorldData::broadphase) finds the overlapping ones, a collision is posted for
+// every pair. Bullets are fast enough to jump over a zombie in a tick, so they're
+// swept from their position at the start of the tick: the broadphase gets a circle
+// around the whole motion, and the time of impact is found for their pairs
 class PhysicsCollisionSystem: public System {
 public:
+  PhysicsCollisionSystem();
+  ~PhysicsCollisionSystem();
+
+  virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
+
+private:
+  Query* m_bodies;
+
+  // NOTE(mizofix): motion is zero for bodies which aren't swept
+  struct BodyMotion {
+    vec2 start;
+    vec2 motion;
+    real radius;
+    bool isSwept;
+  };
+
+  struct Collision {
+    BroadphasePair pair;
+    real           time;
+  };
+
+  std::vector<Entity>         m_entities;
+  std::vector<BodyMotion>     m_motions;
+  BroadphaseBodies            m_bodiesData;
+  std::vector<BroadphasePair> m_pairs;
+  std::vector<Collision>      m_collisions;
+  Broadphase*                 m_broadphase;
 };
 
 // NOTE(mizofix): Shouldn't we integrate penetration resolution to PhysicsCollisionSystem
 
-using MessageContainer = std::list<Message>;
-
 class PenetrationResolutionSystem: public System {
 public:
   virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
 
-  void onCollision(Message message);
-private:
-  MessageContainer m_unprocessedCollisions;
 };
 
 class BulletSystem: public System {
@@ -136,9 +192,8 @@ public:
   virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
 
-  void onCollision(Message message);
 private:
-  MessageContainer m_unprocessedCollisions;
+  Query* m_bullets;
 };
 
 struct Effect {
@@ -161,26 +216,53 @@ public:
   virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
   virtual void draw(ECSContext& context);
-  void onSpawnEffect(Message message);
+
+  std::size_t getEffectsCount() const;
 
 private:
+  void spawnEffect(const SpawnEffectMessage& message);
+
   EffectsContainer m_effects;
   uint32_t         m_maximalEffectsNumber;
 };
 
+// NOTE(mizofix): frames kept for the frame time graph of the overlay
+const static std::size_t OVERLAY_FRAMES_COUNT = 240;
+
 class UIRenderingSystem: public System {
 public:
 
+  UIRenderingSystem(const SystemManager* systemManager);
   ~UIRenderingSystem();
 
   virtual bool init(ECSContext& context);
   virtual void update(ECSContext& context, real deltaTime);
   virtual void draw(ECSContext& context);
 
+  void toggleOverlay();
+
 private:
   vec2 convertToRadarCoords(const vec2& radarPosition, real radarRadius, real maxDistance,
                             const vec2& targetPosition, const vec2& playerPosition);
 
+  // NOTE(mizofix): performance overlay: frame times (with p50, p99 and spikes),
+  // costs of the systems, entities by archetype, effects and particles,
+  // messages and draw calls of the frame
+  void drawOverlay(ECSContext& context);
+  int  drawFrameTimes(int x, int y);
+  int  drawSystemsStats(int x, int y);
+  int  drawEntitiesStats(ECSContext& context, int x, int y);
+  int  drawMessagesStats(int x, int y);
+
+  const SystemManager* m_systemManager;
+  bool                 m_overlayVisible;
+
+  std::array<real, OVERLAY_FRAMES_COUNT> m_frameTimes;
+  std::size_t          m_frameTimesCount;
+  std::size_t          m_nextFrameTime;
+
+  std::vector<SystemStats> m_systemsStats;
+
   Sprite*    m_radarSprite;
   Sprite*    m_weaponSprite;
   Sprite*    m_arrowSprite;
@@ -188,6 +270,11 @@ private:
   Sprite*    m_circleSprite;
   Sprite*    m_reticleSprite;
 
+  Query*     m_players;
+  Query*     m_zombies;
+  Query*     m_boxes;
+  Query*     m_trails;
+
   real       m_lastDeltaTime;
 };
 
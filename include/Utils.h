@@ -3,6 +3,7 @@
 
 #include "Common.h"
 
+const static char DEFAULT_PROFILE_PATH[] = "profile.json";
 
 inline int clamp(int value, int min, int max) {
   if(value < min) {
@@ -18,7 +19,5 @@ inline int clamp(int value, int min, int max) {
 
 WorldData parseCommands(int argc, char** commands);
 
-real randomReal(real start, real end);
-
 
 #endif
@@ -8,6 +8,7 @@
 
 #include "Math.h"
 #include "Message.h"
+#include "Replay.h"
 
 #include "ecs/Registry.h"
 #include "ecs/SystemManager.h"
@@ -15,9 +16,14 @@
 #include "Systems.h"
 
 #include <array>
+#include <chrono>
 #include <vector>
 #include <unordered_map>
 
+// NOTE(mizofix): the most simulation ticks per frame, the rest of the time is
+// dropped, so a slow frame doesn't make the next one even slower
+const static int MAX_SIMULATION_STEPS = 5;
+
 class CrimsonlandFramework : public Framework {
 
 public:
@@ -42,6 +48,13 @@ public:
 
   virtual void onKeyReleased(FRKey k) { }
 
+  bool isHeadless() const;
+
+  // NOTE(mizofix): benchmarks which were asked for on the command line are run
+  // instead of the game
+  bool isBenchmark() const;
+  void runBenchmarks();
+
 private:
 
   bool initMainPart();
@@ -54,15 +67,27 @@ private:
   bool restartGame();
 
   void update();
+  void updateSimulation();
+
+  bool tickHeadless();
+  void applyScriptedInput();
+
+  bool processReplayFrame();
+  ReplayFrame captureInput();
+  void applyInput(const ReplayFrame& frame);
+
   void draw();
   void drawToScreen();
+  void drawPostEffect();
   void updateTimer();
 
   void drawBackground();
   void drawPlants(std::vector<std::pair<Sprite*, vec2>>& plants);
   void drawUI();
 
-  void onPlayerDead(Message message);
+  void dumpProfile();
+
+  void onPlayerDead(const PlayerDeadMessage& message);
   void processDeadMessage();
 
   bool      m_done;
@@ -70,6 +95,8 @@ private:
   WorldData m_worldData;
 
   Registry*          m_registry;
+  CommandBuffer*     m_commands;
+  JobSystem*         m_jobs;
   ECSContext         m_context;
   UIRenderingSystem* m_uiSystem;
   SystemManager      m_systemManager;
@@ -82,6 +109,7 @@ private:
 
   Program m_bumpProgram;
 
+  Subscription m_playerDeadSubscription;
   bool m_playerDeadMessageReceived;
   bool m_playerDeadMessageProcessed;
 
@@ -91,6 +119,22 @@ private:
   float m_lastTime;
   float m_deltaTime;
 
+  // NOTE(mizofix): the world is simulated with a fixed step, the accumulator keeps
+  // the frame time which isn't simulated yet
+  float m_simulationStep;
+  float m_simulationAccumulator;
+
+  uint32_t m_simulationTicksCount;
+
+  uint32_t m_headlessTick;
+  std::chrono::steady_clock::time_point m_headlessStartTime;
+
+  ReplayWriter m_replayWriter;
+  ReplayReader m_replayReader;
+
+  // NOTE(mizofix): the last scroll of the current frame, it's recorded
+  int m_frameMouseWheel;
+
 };
 
 
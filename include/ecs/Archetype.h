@@ -0,0 +1,77 @@
+#ifndef ARCHETYPE_H_INCLUDED
+#define ARCHETYPE_H_INCLUDED
+
+#include "Common.h"
+#include "ecs/Bitset.h"
+#include "ecs/Component.h"
+#include "ecs/ComponentPool.h"
+
+#include <array>
+#include <vector>
+
+const static std::size_t ARCHETYPE_CHUNK_CAPACITY = 128;
+
+// NOTE(mizofix): chunk stores up to ARCHETYPE_CHUNK_CAPACITY entities of the same
+// archetype, each component type lives in its own densely packed array (column).
+// Columns of components which aren't part of the archetype are nullptr. Columns
+// are blocks of component pools of the registry.
+struct ArchetypeChunk {
+
+  template <typename T>
+  T* getColumn() {
+    return reinterpret_cast<T*>(columns[int(T::ID)]);
+  }
+
+  std::size_t size;
+
+  Entity*  entities;
+  std::array<uint8_t*, int(ComponentID::COUNT)> columns;
+};
+
+struct ArchetypeRow {
+  uint32_t chunk;
+  uint32_t index;
+};
+
+// NOTE(mizofix): Archetype owns every entity which has exactly the same set of
+// components. All chunks except the last one are always full, so a walk over
+// an archetype is a linear sweep over its columns.
+class Archetype {
+public:
+
+  // NOTE(mizofix): pools must outlive the archetype
+  Archetype(Bitset components, ComponentPool* entitiesPool, const ComponentPools& pools);
+  ~Archetype();
+
+  // NOTE(mizofix): reserves a row for the entity, components of the row
+  // are left unconstructed
+  ArchetypeRow allocateRow(Entity entity);
+
+  // NOTE(mizofix): fills the row with the last row of the archetype and returns
+  // the entity which was moved (INVALID_ENTITY if nothing has been moved). If
+  // destroyComponents is false, components of the row should be moved-out already
+  Entity removeRow(ArchetypeRow row, bool destroyComponents);
+
+  void* getComponent(ArchetypeRow row, ComponentID id);
+  Entity getEntity(ArchetypeRow row) const;
+
+  const Bitset& getComponents() const;
+  std::size_t getSize() const;
+  std::vector<ArchetypeChunk>& getChunks();
+
+private:
+  void allocateChunk();
+  void releaseLastChunk();
+
+  Bitset m_components;
+  std::size_t m_size;
+
+  std::vector<ArchetypeChunk> m_chunks;
+
+  ComponentPool* m_entitiesPool;
+  ComponentPools m_pools;
+  std::array<const ComponentInfo*, int(ComponentID::COUNT)> m_componentsInfo;
+
+};
+
+#endif
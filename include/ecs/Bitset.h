@@ -1,27 +1,16 @@
-
 #ifndef BITSET_H_INCLUDED
 #define BITSET_H_INCLUDED
 
-#include <stdint.h>
-
-using Bitfield = uint32_t;
-
-class Bitset {
-public:
-
-  Bitset();
-  Bitset(Bitfield bits);
-
-  void setBits(Bitfield bits, bool reset = false);
-  void setBit(Bitfield bit);
+#include "ecs/Component.h"
+#include "ecs/Signature.h"
 
-  bool isSet(Bitfield bit) const;
-  bool isSetBits(Bitfield bits) const;
+// NOTE(mizofix): set of component ids. It's wider than the number of components
+// on purpose, so tag components can be added without touching the queries
+const static std::size_t COMPONENT_SIGNATURE_BITS = 128;
 
-  void clear();
+using Bitset = Signature<COMPONENT_SIGNATURE_BITS>;
 
- private:
-  Bitfield m_bits;
-};
+static_assert(std::size_t(ComponentID::COUNT) <= COMPONENT_SIGNATURE_BITS,
+              "Too many components for the signature, increase COMPONENT_SIGNATURE_BITS");
 
 #endif
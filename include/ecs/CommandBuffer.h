@@ -0,0 +1,82 @@
+#ifndef COMMAND_BUFFER_H_INCLUDED
+#define COMMAND_BUFFER_H_INCLUDED
+
+#include "Common.h"
+#include "ecs/Bitset.h"
+#include "ecs/Component.h"
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class Registry;
+
+// NOTE(mizofix): called at the flush right after the entity is created, so the
+// components can be filled in place
+using EntityInitFunction = std::function<void(Registry*, Entity)>;
+
+enum class EntityCommandType {
+  CREATE,
+  ADD_COMPONENT,
+  REMOVE_COMPONENT
+};
+
+struct EntityCommand {
+  EntityCommandType type;
+  Entity            entity;
+
+  Bitset            components;
+  ComponentID       component;
+
+  // NOTE(mizofix): index into the init functions, -1 if there's none
+  int               initFunction;
+
+  uint32_t          producer;
+};
+
+// NOTE(mizofix): CommandBuffer records structural changes (creation, destruction,
+// addition or removal of components) and applies them to the registry at flush().
+// Systems should use it for anything that happens during a walk over a query, or
+// for changes that other systems may not see until the sync point. Commands are
+// applied in the order of their producers (see setProducer()) and then in the
+// recorded order, destructions go last in one batch. So the result doesn't depend
+// on how threads interleaved. Commands recorded during the flush are kept for the
+// next one.
+// Recording is thread-safe, except for createEntity().
+class CommandBuffer {
+public:
+
+  CommandBuffer(Registry* registry);
+
+  // NOTE(mizofix): sets the producer of the commands recorded by the calling thread,
+  // the scheduler sets it to the index of the running system
+  static void setProducer(uint32_t producer);
+  static uint32_t getProducer();
+
+  // NOTE(mizofix): the handle is reserved in the registry immediately, but the
+  // entity isn't alive until the flush. The reservation changes the registry, so
+  // only exclusive systems may create entities
+  Entity createEntity(Bitset components = Bitset(), EntityInitFunction init = nullptr);
+  void destroyEntity(Entity entity);
+
+  void addComponent(Entity entity, ComponentID component);
+  void removeComponent(Entity entity, ComponentID component);
+
+  void flush();
+
+  bool isEmpty() const;
+
+private:
+
+  void recordCommand(EntityCommand& command);
+
+  Registry* m_registry;
+  std::mutex m_mutex;
+
+  std::vector<EntityCommand>      m_commands;
+  std::vector<EntityInitFunction> m_initFunctions;
+  std::vector<Entity>             m_destroyedEntities;
+
+};
+
+#endif
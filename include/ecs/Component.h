@@ -1,6 +1,11 @@
 #ifndef COMPONENT_H_INCLUDED
 #define COMPONENT_H_INCLUDED
 
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 enum class ComponentID {
   Model,
@@ -17,12 +22,59 @@ enum class ComponentID {
   COUNT
 };
 
-struct Component {
-  virtual ~Component() { }
-  virtual ComponentID getID() = 0;
+// NOTE(mizofix): components are plain structs, each one binds itself to its id
+// with `const static ComponentID ID`, so the registry knows the id of a type
+// at compile time (registry->getComponent<Physics>(entity)).
+
+// NOTE(mizofix): archetypes store components by value, so the only thing they
+// know about a component is its id. ComponentInfo describes how to lay out
+// and handle a component of a given type in a raw memory.
+struct ComponentInfo {
+
+  std::size_t size;
+  std::size_t alignment;
+
+  void (*construct)(void* memory);
+
+  // NOTE(mizofix): move-constructs a component at destination and destroys
+  // the source one
+  void (*move)(void* destination, void* source);
+  void (*destroy)(void* memory);
+
+  template <typename T>
+  static ComponentInfo create() {
+    ComponentInfo info;
+    info.size = sizeof(T);
+    info.alignment = alignof(T);
+    info.construct = [](void* memory) {
+      new (memory) T();
+    };
+    // NOTE(mizofix): trivially copyable components are moved around as raw bytes
+    if constexpr(std::is_trivially_copyable<T>::value) {
+      info.move = [](void* destination, void* source) {
+        std::memcpy(destination, source, sizeof(T));
+      };
+      info.destroy = [](void* memory) { };
+    } else {
+      info.move = [](void* destination, void* source) {
+        T* sourceComponent = static_cast<T*>(source);
+        new (destination) T(std::move(*sourceComponent));
+        sourceComponent->~T();
+      };
+      info.destroy = [](void* memory) {
+        static_cast<T*>(memory)->~T();
+      };
+    }
+
+    return info;
+  }
+
 };
 
-Component* componentFactory(ComponentID component);
+// NOTE(mizofix): returns nullptr for ids which aren't bound to any type
+const ComponentInfo* getComponentInfo(ComponentID component);
+
+const char* getComponentName(ComponentID component);
 
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef COMPONENT_POOL_H_INCLUDED
+#define COMPONENT_POOL_H_INCLUDED
+
+#include "ecs/Component.h"
+
+#include <array>
+#include <vector>
+
+const static std::size_t COMPONENT_POOL_SLAB_BLOCKS = 8;
+
+struct ComponentPoolStats {
+  std::size_t blockSize;
+
+  std::size_t slabs;
+  std::size_t blocks;
+  std::size_t usedBlocks;
+};
+
+// NOTE(mizofix): ComponentPool hands out blocks of the same size, archetype chunks
+// use them as columns of one component type. Blocks are carved from slabs, which are
+// kept until the pool dies, so a block never moves and released blocks are reused by
+// the next chunk through the free-list. Components inside of a block still move on
+// swap-remove, this only keeps the allocator out of the way of entity churn.
+class ComponentPool {
+public:
+
+  ComponentPool(std::size_t blockSize, std::size_t alignment,
+                std::size_t blocksPerSlab = COMPONENT_POOL_SLAB_BLOCKS);
+  ~ComponentPool();
+
+  ComponentPool(const ComponentPool&) = delete;
+  ComponentPool& operator=(const ComponentPool&) = delete;
+
+  void* allocate();
+  void release(void* block);
+
+  ComponentPoolStats getStats() const;
+
+private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  void allocateSlab();
+
+  std::size_t m_blockSize;
+  std::size_t m_alignment;
+  std::size_t m_blocksPerSlab;
+
+  std::size_t m_usedBlocks;
+
+  FreeBlock* m_freeBlocks;
+  std::vector<void*> m_slabs;
+};
+
+// NOTE(mizofix): pools indexed by ComponentID, unbound ids have nullptr
+using ComponentPools = std::array<ComponentPool*, int(ComponentID::COUNT)>;
+
+#endif
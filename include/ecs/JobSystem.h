@@ -0,0 +1,130 @@
+#ifndef JOB_SYSTEM_H_INCLUDED
+#define JOB_SYSTEM_H_INCLUDED
+
+#include "Message.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+using JobFunction = std::function<void()>;
+
+// NOTE(mizofix): number of unfinished jobs, which were run with the counter. A job
+// which waits for a counter depends on every job of it
+class JobCounter {
+public:
+
+  JobCounter(): m_count(0) { }
+
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  bool isDone() const {
+    return m_count.load(std::memory_order_acquire) == 0;
+  }
+
+private:
+  friend class JobSystem;
+
+  std::atomic<uint32_t> m_count;
+};
+
+// NOTE(mizofix): JobSystem runs small jobs on a pool of worker threads. Every thread
+// (the main one included) has its own deque: it pushes and pops jobs at the back,
+// while idle threads steal from the front of the others. A thread which waits for a
+// counter doesn't block, it keeps running jobs until the counter is done, so jobs
+// may run and wait for other jobs. Idle workers sleep until something is pushed.
+// With no workers every job runs on the thread which waits for it.
+// Jobs keep the command buffer producer and the message batch of the thread which
+// has run them (see CommandBuffer::setProducer() and setMessageBatch()).
+class JobSystem {
+public:
+
+  JobSystem(std::size_t workersCount);
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  void run(JobFunction function, JobCounter* counter);
+  void wait(JobCounter* counter);
+
+  // NOTE(mizofix): calls function(begin, end) for ranges of at most batchSize
+  // indices, which cover [0, count), and returns when all of them are done.
+  // The calling thread takes the first range itself
+  template <typename Function>
+  void parallelFor(std::size_t count, std::size_t batchSize, Function function) {
+    batchSize = std::max(batchSize, std::size_t(1));
+    if(count <= batchSize || m_workers.empty()) {
+      if(count > 0) {
+        function(std::size_t(0), count);
+      }
+
+      return;
+    }
+
+    JobCounter counter;
+    for(std::size_t begin = batchSize; begin < count; begin += batchSize) {
+      std::size_t end = std::min(begin + batchSize, count);
+      uint32_t batch = uint32_t(begin / batchSize) + 1;
+      run([&function, begin, end, batch]() {
+        setMessageBatch(batch);
+        function(begin, end);
+      }, &counter);
+    }
+
+    uint32_t previousBatch = getMessageBatch();
+    setMessageBatch(1);
+    function(std::size_t(0), batchSize);
+    setMessageBatch(previousBatch);
+
+    wait(&counter);
+  }
+
+  std::size_t getWorkersCount() const;
+
+  // NOTE(mizofix): hardware threads minus the main one
+  static std::size_t getDefaultWorkersCount();
+
+private:
+
+  struct Job {
+    JobFunction function;
+    JobCounter* counter;
+    uint32_t    producer;
+    uint32_t    messageBatch;
+  };
+
+  struct JobQueue {
+    std::mutex      mutex;
+    std::deque<Job> jobs;
+  };
+
+  void workerLoop(std::size_t queueIndex);
+
+  bool tryRunJob();
+  bool popJob(std::size_t queueIndex, Job& job);
+  bool stealJob(std::size_t queueIndex, Job& job);
+  void runJob(Job& job);
+
+  std::size_t getQueueIndex() const;
+
+  // NOTE(mizofix): the first queue belongs to the main thread (and to any other
+  // thread, which isn't a worker)
+  std::vector<JobQueue*>   m_queues;
+  std::vector<std::thread> m_workers;
+
+  std::atomic<uint32_t>    m_queuedJobs;
+
+  std::mutex               m_sleepMutex;
+  std::condition_variable  m_wakeCondition;
+  bool                     m_stop;
+};
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef QUERY_H_INCLUDED
+#define QUERY_H_INCLUDED
+
+#include "Common.h"
+#include "ecs/Bitset.h"
+#include "ecs/Archetype.h"
+#include "ecs/JobSystem.h"
+#include "Assert.h"
+
+#include <iterator>
+#include <vector>
+
+// NOTE(mizofix): chunks are small, one job takes a few of them
+const static std::size_t QUERY_CHUNKS_PER_JOB = 4;
+
+class QueryIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = Entity;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const Entity*;
+  using reference = const Entity&;
+
+  QueryIterator(const std::vector<Archetype*>* archetypes, std::size_t archetype):
+    m_archetypes(archetypes), m_archetype(archetype), m_chunk(0), m_row(0) {
+    skipEmpty();
+  }
+
+  reference operator*() const {
+    return (*m_archetypes)[m_archetype]->getChunks()[m_chunk].entities[m_row];
+  }
+
+  QueryIterator& operator++() {
+    m_row++;
+    skipEmpty();
+    return *this;
+  }
+
+  QueryIterator operator++(int) {
+    QueryIterator previous = *this;
+    ++(*this);
+    return previous;
+  }
+
+  bool operator==(const QueryIterator& iterator) const {
+    return m_archetype == iterator.m_archetype &&
+           m_chunk == iterator.m_chunk &&
+           m_row == iterator.m_row;
+  }
+
+  bool operator!=(const QueryIterator& iterator) const {
+    return !(*this == iterator);
+  }
+
+private:
+  // NOTE(mizofix): moves to the next existing row, if the current one is out of range
+  void skipEmpty() {
+    while(m_archetype < m_archetypes->size()) {
+      std::vector<ArchetypeChunk>& chunks = (*m_archetypes)[m_archetype]->getChunks();
+      if(m_chunk < chunks.size()) {
+        if(m_row < chunks[m_chunk].size) {
+          return;
+        }
+
+        m_chunk++;
+      } else {
+        m_archetype++;
+        m_chunk = 0;
+      }
+
+      m_row = 0;
+    }
+
+    m_chunk = 0;
+    m_row = 0;
+  }
+
+  const std::vector<Archetype*>* m_archetypes;
+  std::size_t m_archetype;
+  std::size_t m_chunk;
+  std::size_t m_row;
+};
+
+// NOTE(mizofix): builds a Bitset of the component types at compile time
+template <typename ... Ts>
+constexpr Bitset buildComponentsBitfield() {
+  Bitset result;
+  (result.setBit(std::size_t(Ts::ID)), ...);
+
+  return result;
+}
+
+// NOTE(mizofix): Query is a persistent set of entities which have all the desired
+// components. It's created once (usually in System::init) and the registry keeps
+// it up to date, so walking over a query costs only the number of matched entities
+// and doesn't allocate anything. Entities must not be created, destroyed or
+// changed during the walk, collect them and change them after.
+class Query {
+public:
+
+  Query(const Bitset& components): m_components(components) { }
+
+  const Bitset& getComponents() const {
+    return m_components;
+  }
+
+  bool isMatching(const Archetype* archetype) const {
+    return archetype->getComponents().isSetBits(m_components);
+  }
+
+  std::size_t getSize() const {
+    std::size_t result = 0;
+    for(Archetype* archetype: m_archetypes) {
+      result += archetype->getSize();
+    }
+
+    return result;
+  }
+
+  bool isEmpty() const {
+    return getSize() == 0;
+  }
+
+  QueryIterator begin() const {
+    return QueryIterator(&m_archetypes, 0);
+  }
+
+  QueryIterator end() const {
+    return QueryIterator(&m_archetypes, m_archetypes.size());
+  }
+
+  // NOTE(mizofix): calls function(archetype, chunk) for each chunk of matched archetypes
+  template <typename Function>
+  void forEachChunk(Function function) const {
+    for(Archetype* archetype: m_archetypes) {
+      for(ArchetypeChunk& chunk: archetype->getChunks()) {
+        function(*archetype, chunk);
+      }
+    }
+  }
+
+  // NOTE(mizofix): same as forEachChunk(), but chunks are split between jobs, so the
+  // function is called from several threads at once. It may change only the rows
+  // of the given chunk
+  template <typename Function>
+  void parallelForEachChunk(JobSystem& jobs, Function function) const {
+    std::vector<std::pair<Archetype*, ArchetypeChunk*>> chunks;
+    for(Archetype* archetype: m_archetypes) {
+      for(ArchetypeChunk& chunk: archetype->getChunks()) {
+        chunks.emplace_back(archetype, &chunk);
+      }
+    }
+
+    jobs.parallelFor(chunks.size(), QUERY_CHUNKS_PER_JOB,
+                     [&chunks, &function](std::size_t begin, std::size_t end) {
+      for(std::size_t i = begin; i < end; ++i) {
+        function(*chunks[i].first, *chunks[i].second);
+      }
+    });
+  }
+
+  // NOTE(mizofix): calls function(entity, components&...) for each matched entity.
+  // Component columns are resolved once per chunk, so there are no lookups
+  // per entity. The query must contain all of the requested components
+  template <typename ... Ts, typename Function>
+  void each(Function function) const {
+    Assert(isContaining(buildComponentsBitfield<Ts...>()));
+
+    forEachChunk([&function](Archetype& archetype, ArchetypeChunk& chunk) {
+      eachRow(chunk, function, chunk.getColumn<Ts>()...);
+    });
+  }
+
+private:
+  friend class Registry;
+
+  bool isContaining(const Bitset& components) const {
+    return m_components.isSetBits(components);
+  }
+
+  template <typename Function, typename ... Ts>
+  static void eachRow(ArchetypeChunk& chunk, Function& function, Ts* ... columns) {
+    for(std::size_t i = 0; i < chunk.size; ++i) {
+      function(chunk.entities[i], columns[i]...);
+    }
+  }
+
+  Bitset m_components;
+  std::vector<Archetype*> m_archetypes;
+};
+
+#endif
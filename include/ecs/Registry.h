@@ -5,29 +5,56 @@
 #include "Common.h"
 #include "ecs/Bitset.h"
 #include "ecs/Component.h"
+#include "ecs/Archetype.h"
+#include "ecs/ComponentPool.h"
+#include "ecs/Query.h"
 
+#include <deque>
 #include <list>
-#include <array>
+#include <vector>
 #include <unordered_map>
 
-using Components = std::pair<Bitset, std::array<Component*, int(ComponentID::COUNT)>>;
-using Entities = std::unordered_map<Entity, Components>;
+struct EntityLocation {
+  Archetype*   archetype;
+  ArchetypeRow row;
+};
+
+// NOTE(mizofix): slot of a dead entity has nullptr archetype. Reserved slot
+// belongs to an entity which will be created later (see CommandBuffer)
+struct EntitySlot {
+  EntityLocation location;
+  uint32_t       generation;
+  bool           reserved;
+};
+
+// NOTE(mizofix): freed slots aren't reused until there are at least this many of
+// them, so generations of the slots wrap around much slower
+const static std::size_t ENTITY_MIN_FREE_SLOTS = 1024;
+
+using EntitySlots = std::vector<EntitySlot>;
+using Archetypes = std::vector<Archetype*>;
+using Queries = std::vector<Query*>;
 using EntitiesContainer = std::list<Entity>;
 
-template <typename Component>
-Bitfield buildBitfield(Component comp) {
-  return (1 << int(comp));
-}
+// NOTE(mizofix): takes components, and builds based on it a single Bitset
+template <typename ... Components>
+Bitset buildBitfield(Components... comps) {
+  Bitset result;
+  (result.setBit(std::size_t(comps)), ...);
 
-// NOTE(mizofix): takes components, and builds based on it a single Bitfield
-template <typename Component, typename ... Components>
-Bitfield buildBitfield(Component comp, Components... comps) {
-  return (1 << int(comp)) | buildBitfield(comps...);
+  return result;
 }
 
 // NOTE(mizofix): Registry is responsible for storing everything about an entity,
 // managing it's lifetime etc. Even though components are created behind this place,
 // user should not delete them herself.
+// Entities are grouped into archetypes by their set of components, components are
+// stored by value inside of archetype chunks. Adding or removing a component moves
+// the entity (and so all of its components) to another archetype, therefore
+// pointers to components of the entity become invalid.
+// Memory of chunks comes from per-component pools, which are owned by the registry.
+// Prefer createEntity() with the full set of components and filling them in place
+// over adding components one by one, each addition is a move to another archetype.
 class Registry {
 public:
 
@@ -35,42 +62,168 @@ public:
   ~Registry();
 
   Entity createEntity(Bitset components = Bitset());
+
+  // NOTE(mizofix): same as destroyEntities() with a single entity, so listeners of
+  // both messages hear about it
   void destroyEntity(Entity entity);
+
+  // NOTE(mizofix): destroys the entities after a single ECS_ENTITIES_DELETE notification,
+  // ECS_ENTITY_DELETE is sent for each of them only if someone listens to it.
+  // Dead entities and duplicates are skipped
+  void destroyEntities(const Entity* entities, std::size_t count);
+
+  // NOTE(mizofix): returns a handle, which isn't alive until createReservedEntity()
+  // is called with it
+  Entity reserveEntity();
+  void createReservedEntity(Entity entity, Bitset components = Bitset());
   bool isEntityExists(Entity entity) const;
 
+  // NOTE(mizofix): every alive entity has getEntityIndex(entity) < getEntitySlotsCount(),
+  // so systems may keep dense per-entity tables indexed by getEntityIndex()
+  std::size_t getEntitySlotsCount() const;
+
   // NOTE(mizofix): creates new component, based on its id
   void addComponent(Entity entity, ComponentID component);
 
-  // NOTE(mizofix): simply adds a new component, created somewhere
-  // else
-  void addComponent(Entity entity, Component* component);
-
   void removeComponent(Entity entity, ComponentID id);
   bool hasComponent(Entity entity, ComponentID id);
 
-  EntitiesContainer findEntities(Bitfield components);
+  // NOTE(mizofix): constructs T in place from the args, returns nullptr if the
+  // entity is dead or already has the component
+  template <typename T, typename ... Args>
+  T* addComponent(Entity entity, Args&&... args) {
+    EntityLocation* location = getLocation(entity);
+    if(location == nullptr || location->archetype->getComponents().isSet(int(T::ID))) {
+      return nullptr;
+    }
+
+    Bitset newComponents = location->archetype->getComponents();
+    newComponents.setBit(int(T::ID));
+    changeArchetype(entity, *location, newComponents);
+
+    void* memory = location->archetype->getComponent(location->row, T::ID);
+    return new (memory) T(std::forward<Args>(args)...);
+  }
 
-  // NOTE(mizofix): shouldn't we move getID() to static?
   template <typename T>
-  T* getComponent(Entity entity, ComponentID id) {
+  void removeComponent(Entity entity) {
+    removeComponent(entity, T::ID);
+  }
 
-    auto entityIt = m_entities.find(entity);
-    if(entityIt == m_entities.end()) {
-      return nullptr;
+  template <typename T>
+  bool hasComponent(Entity entity) {
+    return hasComponent(entity, T::ID);
+  }
+
+  // NOTE(mizofix): true if the entity is alive and has all the components
+  bool hasComponents(Entity entity, const Bitset& components) const;
+
+  // NOTE(mizofix): returns a query, which is kept up to date by the registry. Queries
+  // with the same components are shared, the registry owns them. Prefer queries
+  // over findEntities() for anything that runs every frame
+  Query* createQuery(const Bitset& components);
+
+  EntitiesContainer findEntities(const Bitset& components);
+
+  ComponentPoolStats getComponentPoolStats(ComponentID id) const;
+  ComponentPoolStats getEntitiesPoolStats() const;
+
+  // NOTE(mizofix): number of alive components of the type, together with pool
+  // stats gives the occupancy of the pool
+  std::size_t getComponentsCount(ComponentID id) const;
+
+  const Archetypes& getArchetypes() const {
+    return m_archetypes;
+  }
+
+  // NOTE(mizofix): registry.each<Transformation, Physics>([](Entity entity,
+  // Transformation& transf, Physics& physics) { ... }) walks over every entity
+  // which has all of the components. Systems should keep their own query and call
+  // Query::each instead, this one has to find the query first
+  template <typename ... Ts, typename Function>
+  void each(Function function) {
+    createQuery(buildComponentsBitfield<Ts...>())->template each<Ts...>(function);
+  }
+
+  // NOTE(mizofix): calls function(archetype, chunk) for each chunk of each archetype
+  // which has all the desired components. Entities must not be created, destroyed
+  // or changed during the walk
+  template <typename Function>
+  void forEachChunk(const Bitset& components, Function function) {
+    // NOTE(mizofix): function is free to create queries, so the matches are our own
+    std::vector<uint32_t> matches;
+    std::size_t matchesCount = matchArchetypes(components, matches);
+    for(std::size_t i = 0; i < matchesCount; ++i) {
+      Archetype* archetype = m_archetypes[matches[i]];
+      for(ArchetypeChunk& chunk: archetype->getChunks()) {
+        function(*archetype, chunk);
+      }
     }
+  }
 
-    if(!entityIt->second.first.isSet(int(id))) {
+  template <typename T>
+  T* getComponent(Entity entity) {
+
+    EntityLocation* location = getLocation(entity);
+    if(location == nullptr) {
       return nullptr;
     }
 
-    return static_cast<T*>(entityIt->second.second[int(id)]);
+    return static_cast<T*>(location->archetype->getComponent(location->row, T::ID));
   }
 
 private:
+
+  uint32_t allocateSlot();
+  void placeEntity(Entity entity, Bitset components);
+  void releaseSlot(Entity entity);
+
+  // NOTE(mizofix): returns nullptr if the entity is dead or never existed
+  EntityLocation* getLocation(Entity entity) {
+    uint32_t index = getEntityIndex(entity);
+    if(index >= m_slots.size()) {
+      return nullptr;
+    }
+
+    EntitySlot& slot = m_slots[index];
+    if(slot.location.archetype == nullptr || slot.generation != getEntityGeneration(entity)) {
+      return nullptr;
+    }
+
+    return &slot.location;
+  }
+
+  const EntityLocation* getLocation(Entity entity) const {
+    return const_cast<Registry*>(this)->getLocation(entity);
+  }
+
+
+  Archetype* getArchetype(Bitset components);
+
+  // NOTE(mizofix): batch-matches signatures of all the archetypes, indices of the
+  // matched ones are put into matches
+  std::size_t matchArchetypes(const Bitset& components, std::vector<uint32_t>& matches) const;
+
+  // NOTE(mizofix): moves the entity to the archetype of newComponents. Components
+  // which the new archetype doesn't have are destroyed, new ones are left unconstructed
+  void changeArchetype(Entity entity, EntityLocation& location, Bitset newComponents);
+
   void clear();
 
-  uint32_t m_newEntityID;
-  Entities m_entities;
+  EntitySlots          m_slots;
+  std::deque<uint32_t> m_freeSlots;
+
+  Archetypes m_archetypes;
+  std::unordered_map<Bitset, Archetype*> m_archetypesMap;
+
+  // NOTE(mizofix): signatures of m_archetypes, kept contiguous for matchSignatures()
+  std::vector<Bitset>   m_archetypeSignatures;
+  std::vector<uint32_t> m_archetypeMatches;
+
+  Queries    m_queries;
+
+  ComponentPool* m_entitiesPool;
+  ComponentPools m_componentPools;
 
 };
 
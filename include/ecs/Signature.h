@@ -0,0 +1,178 @@
+#ifndef SIGNATURE_H_INCLUDED
+#define SIGNATURE_H_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// NOTE(mizofix): fixed-width set of bits, stored as 64-bit words. Signatures of
+// 128 and 256 bits are aligned to their size, so an array of them can be matched
+// with one SSE/AVX load per signature (see matchSignatures())
+template <std::size_t Bits>
+class alignas(Bits >= 256 ? 32 : (Bits >= 128 ? 16 : 8)) Signature {
+public:
+
+  const static std::size_t BITS = Bits;
+  const static std::size_t WORDS = (Bits + 63) / 64;
+
+  constexpr Signature(): m_words{} { }
+
+  constexpr void setBit(std::size_t bit) {
+    m_words[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+
+  constexpr void resetBit(std::size_t bit) {
+    m_words[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+  }
+
+  constexpr bool isSet(std::size_t bit) const {
+    return (m_words[bit / 64] >> (bit % 64)) & 1;
+  }
+
+  // NOTE(mizofix): true if every bit of bits is set in the signature
+  constexpr bool isSetBits(const Signature& bits) const {
+    uint64_t missing = 0;
+    for(std::size_t i = 0; i < WORDS; ++i) {
+      missing |= bits.m_words[i] & ~m_words[i];
+    }
+
+    return missing == 0;
+  }
+
+  constexpr bool isIntersecting(const Signature& signature) const {
+    uint64_t common = 0;
+    for(std::size_t i = 0; i < WORDS; ++i) {
+      common |= m_words[i] & signature.m_words[i];
+    }
+
+    return common != 0;
+  }
+
+  constexpr bool isEmpty() const {
+    uint64_t bits = 0;
+    for(std::size_t i = 0; i < WORDS; ++i) {
+      bits |= m_words[i];
+    }
+
+    return bits == 0;
+  }
+
+  constexpr void clear() {
+    for(std::size_t i = 0; i < WORDS; ++i) {
+      m_words[i] = 0;
+    }
+  }
+
+  constexpr Signature& operator|=(const Signature& signature) {
+    for(std::size_t i = 0; i < WORDS; ++i) {
+      m_words[i] |= signature.m_words[i];
+    }
+
+    return *this;
+  }
+
+  constexpr bool operator==(const Signature& signature) const {
+    uint64_t difference = 0;
+    for(std::size_t i = 0; i < WORDS; ++i) {
+      difference |= m_words[i] ^ signature.m_words[i];
+    }
+
+    return difference == 0;
+  }
+
+  constexpr bool operator!=(const Signature& signature) const {
+    return !(*this == signature);
+  }
+
+  constexpr uint64_t getWord(std::size_t index) const {
+    return m_words[index];
+  }
+
+  std::size_t getHash() const {
+    uint64_t hash = 14695981039346656037ull;
+    for(std::size_t i = 0; i < WORDS; ++i) {
+      hash = (hash ^ m_words[i]) * 1099511628211ull;
+    }
+
+    return std::size_t(hash);
+  }
+
+private:
+  uint64_t m_words[WORDS];
+};
+
+template <std::size_t Bits>
+constexpr Signature<Bits> operator|(Signature<Bits> a, const Signature<Bits>& b) {
+  a |= b;
+  return a;
+}
+
+namespace std {
+
+  template <std::size_t Bits>
+  struct hash<Signature<Bits>> {
+    std::size_t operator()(const Signature<Bits>& signature) const {
+      return signature.getHash();
+    }
+  };
+
+}
+
+// NOTE(mizofix): tests count contiguous signatures against the mask, writes indices
+// of the signatures which have every bit of the mask into matches (it has to have
+// room for count indices) and returns the number of matches. Indices are written
+// without branches, SSE2/AVX2 test a whole 128/256-bit signature at once
+template <std::size_t Bits>
+std::size_t matchSignatures(const Signature<Bits>* signatures, std::size_t count,
+                            const Signature<Bits>& mask, uint32_t* matches) {
+  using SignatureType = Signature<Bits>;
+  std::size_t matchesCount = 0;
+
+#if defined(__AVX2__)
+  if constexpr(SignatureType::WORDS == 4) {
+    const __m256i maskBits = _mm256_load_si256(reinterpret_cast<const __m256i*>(&mask));
+    for(std::size_t i = 0; i < count; ++i) {
+      const __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i*>(&signatures[i]));
+
+      // NOTE(mizofix): testc is true if every bit of the mask is set in bits
+      matches[matchesCount] = uint32_t(i);
+      matchesCount += std::size_t(_mm256_testc_si256(bits, maskBits));
+    }
+
+    return matchesCount;
+  }
+#endif
+
+#if defined(__SSE2__)
+  if constexpr(SignatureType::WORDS == 2) {
+    const __m128i maskBits = _mm_load_si128(reinterpret_cast<const __m128i*>(&mask));
+    for(std::size_t i = 0; i < count; ++i) {
+      const __m128i bits = _mm_load_si128(reinterpret_cast<const __m128i*>(&signatures[i]));
+      const __m128i missing = _mm_andnot_si128(bits, maskBits);
+      const int isMatching = _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+
+      matches[matchesCount] = uint32_t(i);
+      matchesCount += std::size_t(isMatching);
+    }
+
+    return matchesCount;
+  }
+#endif
+
+  for(std::size_t i = 0; i < count; ++i) {
+    matches[matchesCount] = uint32_t(i);
+    matchesCount += std::size_t(signatures[i].isSetBits(mask));
+  }
+
+  return matchesCount;
+}
+
+#endif
@@ -2,23 +2,140 @@
 #define SYSTEM_H_INCLUDED
 
 #include "Common.h"
+#include "ecs/Bitset.h"
+#include "Profiler.h"
+
+#include <string>
 
 class Registry;
+class CommandBuffer;
+class JobSystem;
 
+// NOTE(mizofix): commands are flushed after all the systems are updated. Systems
+// may split their walks over queries into jobs (see Query::parallelForEachChunk()).
+// Systems are updated with a fixed step, interpolationFactor is a part of the step
+// passed since the last update, draw() uses it to blend the last two ticks
 struct ECSContext {
-  Registry* registry;
-  WorldData data;
+  Registry*      registry;
+  CommandBuffer* commands;
+  JobSystem*     jobs;
+  WorldData      data;
+  real           interpolationFactor;
 };
 
 #include "ecs/Registry.h"
+#include "ecs/CommandBuffer.h"
+#include "ecs/JobSystem.h"
+
+// NOTE(mizofix): shared things, which aren't components, but still can't be
+// touched by two systems at once:
+// Messages  - notifies messages, or keeps a state, which is changed by message
+//             handlers. Handlers are called on the thread of the sender. Posting
+//             messages (see post()) and reading the posted messages of the last
+//             tick (see getMessages()) aren't uses
+// WorldData - reads or writes mutable parts of ECSContext::data (round, counters)
+// ECSContext::commands isn't a resource, recording into it is thread-safe
+enum class SystemResource {
+  Messages,
+  WorldData,
+  COUNT
+};
+
+// NOTE(mizofix): describes what a system touches during update(). Two systems
+// conflict if one of them writes a component which the other one reads or writes,
+// or if they share a resource. Until anything is declared the system is exclusive,
+// i.e. it conflicts with every other system. Exclusive is also the right choice for
+// systems which create or destroy entities directly through the registry.
+class SystemAccess {
+public:
+
+  SystemAccess(): m_exclusive(true), m_resources(0) { }
+
+  SystemAccess& read(ComponentID component) {
+    m_exclusive = false;
+    m_reads.setBit(std::size_t(component));
+    return *this;
+  }
+
+  SystemAccess& write(ComponentID component) {
+    m_exclusive = false;
+    m_writes.setBit(std::size_t(component));
+    return *this;
+  }
+
+  SystemAccess& use(SystemResource resource) {
+    m_exclusive = false;
+    m_resources |= 1u << uint32_t(resource);
+    return *this;
+  }
+
+  // NOTE(mizofix): false for systems which touch neither components nor resources
+  SystemAccess& setExclusive(bool exclusive = true) {
+    m_exclusive = exclusive;
+    return *this;
+  }
+
+  bool isExclusive() const {
+    return m_exclusive;
+  }
+
+  bool isConflicting(const SystemAccess& access) const {
+    if(m_exclusive || access.m_exclusive) {
+      return true;
+    }
+
+    if(m_resources & access.m_resources) {
+      return true;
+    }
+
+    return m_writes.isIntersecting(access.m_reads | access.m_writes) ||
+           access.m_writes.isIntersecting(m_reads | m_writes);
+  }
+
+private:
+  bool     m_exclusive;
+
+  Bitset   m_reads;
+  Bitset   m_writes;
+  uint32_t m_resources;
+};
 
 class System {
 public:
+  System(): m_profilerName("") { }
   virtual ~System() { }
 
   virtual bool init(ECSContext& context) { return true; }
   virtual void update(ECSContext& context, real deltaTime) { }
   virtual void draw(ECSContext& context) { }
+
+  const SystemAccess& getAccess() const {
+    return m_access;
+  }
+
+  // NOTE(mizofix): set by SystemManager, profiler zones are named after it
+  const std::string& getName() const {
+    return m_name;
+  }
+
+  void setName(const std::string& name) {
+    m_name = name;
+    m_profilerName = internProfilerName(name.c_str());
+  }
+
+  // NOTE(mizofix): the name for the profiler events, it outlives the system
+  const char* getProfilerName() const {
+    return m_profilerName;
+  }
+
+protected:
+
+  // NOTE(mizofix): should be declared in init()
+  SystemAccess m_access;
+
+private:
+  std::string  m_name;
+  const char*  m_profilerName;
 };
 
 #endif
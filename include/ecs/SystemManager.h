@@ -2,26 +2,44 @@
 #define SYSTEM_MANAGER_H_INCLUDED
 
 #include "ecs/System.h"
+#include "ecs/SystemScheduler.h"
+#include "Message.h"
+#include "Profiler.h"
 
-#include <list>
+#include <algorithm>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+// NOTE(mizofix): times are in milliseconds, update time is the one of the last tick
+struct SystemStats {
+  const System* system;
+  real          updateTime;
+  real          drawTime;
+};
+
+// NOTE(mizofix): systems are updated by the scheduler, in parallel where their
+// declared access allows it, and drawn one after another on the main thread
 class SystemManager {
 public:
 
+  SystemManager(): m_isGraphDirty(true) { }
+
   ~SystemManager() {
     clear();
   }
 
   bool addSystem(ECSContext& context, System* system, const std::string& name) {
+    system->setName(name);
     if(!system->init(context)) {
       delete system;
       return false;
     }
 
-    Assert(m_systemPairs.emplace(name, system).second);
+    bool isAdded = m_systemPairs.emplace(name, system).second;
+    Assert(isAdded);
     m_systems.push_back(system);
+    m_isGraphDirty = true;
 
     return true;
   }
@@ -29,21 +47,56 @@ public:
   void removeSystem(const std::string& name) {
     auto systemIt = m_systemPairs.find(name);
     if(systemIt != m_systemPairs.end()) {
-      m_systems.remove(systemIt->second);
+      m_systems.erase(std::find(m_systems.begin(), m_systems.end(), systemIt->second));
       delete systemIt->second;
       m_systemPairs.erase(systemIt);
+      m_drawTimes.clear();
+      m_isGraphDirty = true;
     }
   }
 
   void updateSystems(ECSContext& context, real deltaTime) {
-    for(auto system: m_systems) {
-      system->update(context, deltaTime);
+    if(m_isGraphDirty) {
+      m_scheduler.build(m_systems);
+      m_isGraphDirty = false;
     }
+
+    m_scheduler.update(context, deltaTime);
+
+    {
+      PROFILE_ZONE("commands_flush", "update");
+      context.commands->flush();
+    }
+
+    // NOTE(mizofix): messages posted during this tick are read during the next one
+    swapMessageQueues();
   }
 
   void drawSystems(ECSContext& context) {
-    for(auto system: m_systems) {
-      system->draw(context);
+    m_drawTimes.resize(m_systems.size());
+    for(std::size_t i = 0; i < m_systems.size(); ++i) {
+      uint64_t startTime = getProfilerTime();
+      m_systems[i]->draw(context);
+
+      uint64_t endTime = getProfilerTime();
+      recordProfilerEvent(m_systems[i]->getProfilerName(), "draw", startTime, endTime);
+      m_drawTimes[i] = endTime - startTime;
+    }
+  }
+
+  System* getSystem(const std::string& name) const {
+    auto systemIt = m_systemPairs.find(name);
+    return (systemIt != m_systemPairs.end()) ? systemIt->second : nullptr;
+  }
+
+  void getSystemsStats(std::vector<SystemStats>& stats) const {
+    stats.clear();
+    for(std::size_t i = 0; i < m_systems.size(); ++i) {
+      SystemStats systemStats;
+      systemStats.system = m_systems[i];
+      systemStats.updateTime = m_isGraphDirty ? 0.0f : real(m_scheduler.getUpdateTime(i)) / 1000000.0f;
+      systemStats.drawTime = (i < m_drawTimes.size()) ? real(m_drawTimes[i]) / 1000000.0f : 0.0f;
+      stats.push_back(systemStats);
     }
   }
 
@@ -54,12 +107,17 @@ public:
 
     m_systemPairs.clear();
     m_systems.clear();
+    m_isGraphDirty = true;
   }
 
 private:
 
   std::unordered_map<std::string, System*> m_systemPairs;
-  std::list<System*> m_systems;
+  std::vector<System*> m_systems;
+  std::vector<uint64_t> m_drawTimes;
+
+  SystemScheduler m_scheduler;
+  bool            m_isGraphDirty;
 
 };
 
@@ -0,0 +1,52 @@
+#ifndef SYSTEM_SCHEDULER_H_INCLUDED
+#define SYSTEM_SCHEDULER_H_INCLUDED
+
+#include "ecs/System.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// NOTE(mizofix): runs update() of the systems as jobs of ECSContext::jobs. Systems
+// are nodes of a dependency graph: a system depends on every earlier (in the order
+// of registration) system it conflicts with (see SystemAccess). So conflicting
+// systems always run in the order of registration, while the others may run at
+// the same time. A system is run as a job when the last of its dependencies is
+// done, update() returns when every system is done. With no workers systems simply
+// run one after another.
+class SystemScheduler {
+public:
+
+  SystemScheduler();
+
+  // NOTE(mizofix): builds the graph, has to be called when the set of
+  // systems changes
+  void build(const std::vector<System*>& systems);
+
+  void update(ECSContext& context, real deltaTime);
+
+  // NOTE(mizofix): time of the last update() of the system in nanoseconds, systems
+  // are in the order they were given to build()
+  uint64_t getUpdateTime(std::size_t system) const;
+
+private:
+
+  struct SystemNode {
+    System*                  system;
+    std::vector<std::size_t> dependents;
+    std::size_t              dependenciesCount;
+    uint64_t                 updateTime;
+  };
+
+  void updateNode(std::size_t node, ECSContext& context, real deltaTime);
+
+  void runNode(std::size_t node, JobCounter* counter);
+
+  std::vector<SystemNode>                     m_nodes;
+  std::unique_ptr<std::atomic<std::size_t>[]> m_remainingDependencies;
+
+  ECSContext*                                 m_context;
+  real                                        m_deltaTime;
+};
+
+#endif
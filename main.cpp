@@ -2,5 +2,15 @@
 
 int main(int argc, char** argv)
 {
-  return run(new CrimsonlandFramework(argc, argv));
+  CrimsonlandFramework* framework = new CrimsonlandFramework(argc, argv);
+  if(framework->isBenchmark()) {
+    framework->runBenchmarks();
+    return 0;
+  }
+
+  if(framework->isHeadless()) {
+    return runHeadless(framework);
+  }
+
+  return run(framework);
 }
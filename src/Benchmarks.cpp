@@ -0,0 +1,266 @@
+#include "Benchmarks.h"
+#include "Components.h"
+#include "Profiler.h"
+#include "Random.h"
+
+#include "ecs/JobSystem.h"
+#include "ecs/Registry.h"
+
+#include <cstdio>
+#include <vector>
+
+static void generateBenchmarkEntities(Random& random, uint32_t entitiesCount, Registry& registry) {
+  registry.createEntity(buildBitfield(ComponentID::Model, ComponentID::Transformation, ComponentID::Attributes,
+                                      ComponentID::Player, ComponentID::Physics));
+
+  for(uint32_t i = 1; i < entitiesCount; ++i) {
+    uint32_t kind = random.nextInt(20);
+    Entity entity;
+    if(kind < 12) {
+      entity = registry.createEntity(buildBitfield(ComponentID::Model, ComponentID::Transformation,
+                                                   ComponentID::Physics, ComponentID::Zombie,
+                                                   ComponentID::Attributes));
+    } else if(kind < 19) {
+      entity = registry.createEntity(buildBitfield(ComponentID::Physics, ComponentID::Transformation,
+                                                   ComponentID::Bullet));
+
+      // NOTE(mizofix): every bullet leaves a trail
+      Entity trail = registry.createEntity(buildBitfield(ComponentID::Trail));
+      registry.getComponent<Trail>(trail)->target = entity;
+      ++i;
+    } else {
+      entity = registry.createEntity(buildBitfield(ComponentID::Model, ComponentID::Transformation,
+                                                   ComponentID::Physics, ComponentID::Weapon));
+    }
+
+    registry.getComponent<Transformation>(entity)->position = vec2(random.nextReal(0.0f, 3000.0f),
+                                                                   random.nextReal(0.0f, 3000.0f));
+  }
+}
+
+void runQueryBenchmark(uint32_t seed) {
+  const uint32_t entitiesCounts[] = {1000, 2500, 5000, 10000};
+
+  // NOTE(mizofix): the first frame isn't timed
+  const uint32_t framesCount = 100;
+
+  // NOTE(mizofix): what the systems walk over during a frame
+  const Bitset frameComponents[] = {
+    buildBitfield(ComponentID::Trail),
+    buildBitfield(ComponentID::Model, ComponentID::Transformation, ComponentID::Physics,
+                  ComponentID::Attributes, ComponentID::Zombie),
+    buildBitfield(ComponentID::Transformation, ComponentID::Physics, ComponentID::Player,
+                  ComponentID::Attributes),
+    buildBitfield(ComponentID::Transformation, ComponentID::Player),
+    buildBitfield(ComponentID::Zombie, ComponentID::Attributes, ComponentID::Transformation),
+    buildBitfield(ComponentID::Weapon),
+    buildBitfield(ComponentID::Transformation, ComponentID::Attributes, ComponentID::Physics),
+    buildBitfield(ComponentID::Model, ComponentID::Transformation),
+    buildBitfield(ComponentID::Transformation),
+    buildBitfield(ComponentID::Transformation, ComponentID::Physics),
+    buildBitfield(ComponentID::Transformation, ComponentID::Physics),
+    buildBitfield(ComponentID::Bullet),
+    buildBitfield(ComponentID::Player, ComponentID::Attributes),
+    buildBitfield(ComponentID::Transformation, ComponentID::Zombie),
+    buildBitfield(ComponentID::Transformation, ComponentID::Weapon),
+    buildBitfield(ComponentID::Trail),
+  };
+
+  Random random(seed);
+
+  printf("walks over the components of the systems (%zu per frame):\n",
+         sizeof(frameComponents) / sizeof(frameComponents[0]));
+  printf("%8s %12s %12s %8s\n", "entities", "find ms", "query ms", "speedup");
+
+  for(uint32_t entitiesCount: entitiesCounts) {
+    Registry* registry = new Registry();
+    generateBenchmarkEntities(random, entitiesCount, *registry);
+
+    std::vector<Query*> queries;
+    for(const Bitset& components: frameComponents) {
+      queries.push_back(registry->createQuery(components));
+    }
+
+    // NOTE(mizofix): both ways read the position of every entity which has one,
+    // so the walks can't be thrown away and have to give the same sum. The sum is
+    // an integer one, so it doesn't depend on the order of the entities
+    uint64_t findSum = 0;
+    uint64_t querySum = 0;
+    uint64_t findTime = 0;
+    uint64_t queryTime = 0;
+
+    for(uint32_t frame = 0; frame <= framesCount; ++frame) {
+      uint64_t sum = 0;
+      uint64_t startTime = getProfilerTime();
+      for(const Bitset& components: frameComponents) {
+        bool hasTransformation = components.isSet(int(ComponentID::Transformation));
+        for(Entity entity: registry->findEntities(components)) {
+          sum += hasTransformation ? uint64_t(registry->getComponent<Transformation>(entity)->position.x) : 1;
+        }
+      }
+
+      uint64_t time = getProfilerTime() - startTime;
+      if(frame > 0) {
+        findTime += time;
+        findSum = sum;
+      }
+
+      sum = 0;
+      startTime = getProfilerTime();
+      for(const Query* query: queries) {
+        bool hasTransformation = query->getComponents().isSet(int(ComponentID::Transformation));
+        query->forEachChunk([&sum, hasTransformation](Archetype& archetype, ArchetypeChunk& chunk) {
+          if(!hasTransformation) {
+            sum += chunk.size;
+            return;
+          }
+
+          Transformation* transformations = chunk.getColumn<Transformation>();
+          for(std::size_t i = 0; i < chunk.size; ++i) {
+            sum += uint64_t(transformations[i].position.x);
+          }
+        });
+      }
+
+      time = getProfilerTime() - startTime;
+      if(frame > 0) {
+        queryTime += time;
+        querySum = sum;
+      }
+    }
+
+    printf("%8u %12.3f %12.3f %7.1fx%s\n", entitiesCount,
+           double(findTime) / framesCount / 1000000.0, double(queryTime) / framesCount / 1000000.0,
+           double(findTime) / double(queryTime), (findSum == querySum) ? "" : " [error] sums differ");
+
+    delete registry;
+  }
+}
+
+// NOTE(mizofix): the body moves along its velocity, which turns a bit, so there's
+// some work per transformation besides the loads and stores
+static void moveBenchmarkBody(Transformation& transf, vec2& velocity, real deltaTime) {
+  velocity = velocity + vec2(-velocity.y, velocity.x) * (0.5f * deltaTime);
+  transf.previousPosition = transf.position;
+  transf.position += velocity * deltaTime;
+  transf.angle = vecToDeg(velocity);
+}
+
+void runJobsBenchmark(uint32_t seed, std::size_t threadsCount) {
+  const uint32_t bodiesCount = 100000;
+  const std::size_t bodiesPerJob = 1024;
+
+  // NOTE(mizofix): the first update isn't timed
+  const uint32_t updatesCount = 50;
+  const real deltaTime = 1.0f / 60.0f;
+
+  Random random(seed);
+  std::vector<Transformation> startTransformations(bodiesCount);
+  std::vector<vec2> startVelocities(bodiesCount);
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    startTransformations[i].position = vec2(random.nextReal(-1500.0f, 1500.0f), random.nextReal(-1500.0f, 1500.0f));
+    startVelocities[i] = degToVec(random.nextReal(0.0f, 360.0f)) * random.nextReal(10.0f, 200.0f);
+  }
+
+  // NOTE(mizofix): the velocity lives in Physics, so the chunks are walked the way
+  // the systems walk them
+  Registry* registry = new Registry();
+  Query* bodies = registry->createQuery(buildBitfield(ComponentID::Transformation, ComponentID::Physics));
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    registry->createEntity(buildBitfield(ComponentID::Transformation, ComponentID::Physics));
+  }
+
+  std::vector<Transformation> transformations;
+  std::vector<vec2> velocities;
+  std::vector<Transformation> firstTransformations;
+
+  printf("updates of %u transformations (%zu per job, %zu chunks of %zu):\n", bodiesCount, bodiesPerJob,
+         (bodiesCount + ARCHETYPE_CHUNK_CAPACITY - 1) / ARCHETYPE_CHUNK_CAPACITY, ARCHETYPE_CHUNK_CAPACITY);
+  printf("%8s %14s %8s %14s %8s\n", "threads", "array ms", "speedup", "chunks ms", "speedup");
+
+  double firstArrayTime = 0.0;
+  double firstChunksTime = 0.0;
+
+  for(std::size_t threads = 1; threads <= threadsCount; ++threads) {
+    JobSystem* jobs = new JobSystem(threads - 1);
+
+    transformations = startTransformations;
+    velocities = startVelocities;
+
+    uint64_t arrayTime = 0;
+    for(uint32_t update = 0; update <= updatesCount; ++update) {
+      uint64_t startTime = getProfilerTime();
+      jobs->parallelFor(bodiesCount, bodiesPerJob, [&transformations, &velocities, deltaTime](std::size_t begin,
+                                                                                               std::size_t end) {
+        for(std::size_t i = begin; i < end; ++i) {
+          moveBenchmarkBody(transformations[i], velocities[i], deltaTime);
+        }
+      });
+
+      if(update > 0) {
+        arrayTime += getProfilerTime() - startTime;
+      }
+    }
+
+    std::size_t body = 0;
+    bodies->forEachChunk([&body, &startTransformations, &startVelocities](Archetype& archetype,
+                                                                         ArchetypeChunk& chunk) {
+      Transformation* chunkTransformations = chunk.getColumn<Transformation>();
+      Physics* physics = chunk.getColumn<Physics>();
+      for(std::size_t i = 0; i < chunk.size; ++i, ++body) {
+        chunkTransformations[i] = startTransformations[body];
+        physics[i].velocity = startVelocities[body];
+      }
+    });
+
+    uint64_t chunksTime = 0;
+    for(uint32_t update = 0; update <= updatesCount; ++update) {
+      uint64_t startTime = getProfilerTime();
+      bodies->parallelForEachChunk(*jobs, [deltaTime](Archetype& archetype, ArchetypeChunk& chunk) {
+        Transformation* chunkTransformations = chunk.getColumn<Transformation>();
+        Physics* physics = chunk.getColumn<Physics>();
+        for(std::size_t i = 0; i < chunk.size; ++i) {
+          moveBenchmarkBody(chunkTransformations[i], physics[i].velocity, deltaTime);
+        }
+      });
+
+      if(update > 0) {
+        chunksTime += getProfilerTime() - startTime;
+      }
+    }
+
+    // NOTE(mizofix): every body is updated on its own, so the results don't depend
+    // on the number of threads and both ways give the same ones
+    if(threads == 1) {
+      firstTransformations = transformations;
+    }
+
+    bool isCorrect = true;
+    body = 0;
+    bodies->forEachChunk([&body, &isCorrect, &transformations, &firstTransformations](Archetype& archetype,
+                                                                                     ArchetypeChunk& chunk) {
+      Transformation* chunkTransformations = chunk.getColumn<Transformation>();
+      for(std::size_t i = 0; i < chunk.size; ++i, ++body) {
+        const vec2& position = transformations[body].position;
+        isCorrect = isCorrect && chunkTransformations[i].position.x == position.x &&
+                    chunkTransformations[i].position.y == position.y &&
+                    firstTransformations[body].position.x == position.x &&
+                    firstTransformations[body].position.y == position.y;
+      }
+    });
+
+    double arrayMs = double(arrayTime) / updatesCount / 1000000.0;
+    double chunksMs = double(chunksTime) / updatesCount / 1000000.0;
+    if(threads == 1) {
+      firstArrayTime = arrayMs;
+      firstChunksTime = chunksMs;
+    }
+
+    printf("%8zu %14.3f %7.2fx %14.3f %7.2fx%s\n", threads, arrayMs, firstArrayTime / arrayMs,
+           chunksMs, firstChunksTime / chunksMs, isCorrect ? "" : " [error] results differ");
+
+    delete jobs;
+  }
+
+  delete registry;
+}
@@ -0,0 +1,450 @@
+#include "Broadphase.h"
+#include "Assert.h"
+#include "Profiler.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const uint32_t NO_BODY = uint32_t(-1);
+
+static bool isOverlapping(real xA, real yA, real radiusA, real xB, real yB, real radiusB) {
+  real dx = xB - xA;
+  real dy = yB - yA;
+  real radius = radiusA + radiusB;
+
+  return dx * dx + dy * dy < radius * radius;
+}
+
+void sortPairs(std::vector<BroadphasePair>& pairs) {
+  std::sort(pairs.begin(), pairs.end(), [](const BroadphasePair& pairA, const BroadphasePair& pairB) {
+    return (pairA.a != pairB.a) ? pairA.a < pairB.a : pairA.b < pairB.b;
+  });
+}
+
+void Broadphase::testCandidates(std::vector<BroadphasePair>& pairs, std::size_t minCount) {
+  if(m_candidates.empty() || m_candidates.size() < minCount) {
+    return;
+  }
+
+  // NOTE(mizofix): contacts only grow, so they aren't filled with zeros every time
+  if(m_contacts.size() < m_candidates.size()) {
+    m_contacts.resize(m_candidates.size());
+  }
+
+  std::size_t contactsCount = findContacts(m_circles.data(), m_candidates.data(), m_candidates.size(),
+                                           m_contacts.data());
+  pairs.insert(pairs.end(), m_contacts.begin(), m_contacts.begin() + contactsCount);
+
+  m_pairTestsCount += m_candidates.size();
+  m_candidates.clear();
+}
+
+Broadphase* createBroadphase(BroadphaseType type) {
+  switch(type) {
+  case BroadphaseType::GRID: return new GridBroadphase();
+  case BroadphaseType::SWEEP_AND_PRUNE: return new SweepAndPruneBroadphase();
+  default: break;
+  }
+
+  Assert(false);
+  return nullptr;
+}
+
+const char* getBroadphaseName(BroadphaseType type) {
+  switch(type) {
+  case BroadphaseType::GRID: return "grid";
+  case BroadphaseType::SWEEP_AND_PRUNE: return "sap";
+  default: return "unknown";
+  }
+}
+
+void GridBroadphase::findPairs(const BroadphaseBodies& bodies, std::vector<BroadphasePair>& pairs) {
+  pairs.clear();
+  m_pairTestsCount = 0;
+  packCircles(bodies, m_circles);
+
+  uint32_t bodiesCount = uint32_t(bodies.getSize());
+  if(bodiesCount < 2) {
+    return;
+  }
+
+  real minX = bodies.x[0], maxX = bodies.x[0];
+  real minY = bodies.y[0], maxY = bodies.y[0];
+  real maxRadius = 0.0f;
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    minX = std::min(minX, bodies.x[i]);
+    maxX = std::max(maxX, bodies.x[i]);
+    minY = std::min(minY, bodies.y[i]);
+    maxY = std::max(maxY, bodies.y[i]);
+    maxRadius = std::max(maxRadius, bodies.radius[i]);
+  }
+
+  real cellSize = std::max(maxRadius * 2.0f, GRID_MIN_CELL_SIZE);
+  uint32_t columns = 0, rows = 0;
+
+  // NOTE(mizofix): bodies far from each other would make too many empty cells
+  std::size_t maxCellsCount = std::max(bodiesCount * GRID_CELLS_PER_BODY, std::size_t(1024));
+  while(true) {
+    columns = uint32_t((maxX - minX) / cellSize) + 1;
+    rows = uint32_t((maxY - minY) / cellSize) + 1;
+    if(std::size_t(columns) * rows <= maxCellsCount) {
+      break;
+    }
+
+    cellSize *= 2.0f;
+  }
+
+  uint32_t cellsCount = columns * rows;
+  m_cellStarts.assign(cellsCount + 1, 0);
+  m_bodyCells.resize(bodiesCount);
+
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    uint32_t column = std::min(uint32_t((bodies.x[i] - minX) / cellSize), columns - 1);
+    uint32_t row = std::min(uint32_t((bodies.y[i] - minY) / cellSize), rows - 1);
+
+    uint32_t cell = row * columns + column;
+    m_bodyCells[i] = cell;
+    m_cellStarts[cell + 1]++;
+  }
+
+  for(uint32_t cell = 0; cell < cellsCount; ++cell) {
+    m_cellStarts[cell + 1] += m_cellStarts[cell];
+  }
+
+  m_sortedLayers.resize(bodiesCount);
+  m_sortedMasks.resize(bodiesCount);
+  m_sortedBodies.resize(bodiesCount);
+
+  // NOTE(mizofix): bodies of a cell stay in the order of their indices. The start
+  // of a cell is used as its next free place, so it ends up at the end of the cell
+  // and the starts are shifted back afterwards
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    uint32_t place = m_cellStarts[m_bodyCells[i]]++;
+    m_sortedLayers[place] = bodies.layers[i];
+    m_sortedMasks[place] = bodies.masks[i];
+    m_sortedBodies[place] = i;
+  }
+
+  for(uint32_t cell = cellsCount; cell > 0; --cell) {
+    m_cellStarts[cell] = m_cellStarts[cell - 1];
+  }
+  m_cellStarts[0] = 0;
+
+  for(uint32_t row = 0; row < rows; ++row) {
+    for(uint32_t column = 0; column < columns; ++column) {
+      uint32_t cell = row * columns + column;
+      if(m_cellStarts[cell] == m_cellStarts[cell + 1]) {
+        continue;
+      }
+
+      addCandidates(cell, cell);
+
+      if(column + 1 < columns) {
+        addCandidates(cell, cell + 1);
+      }
+
+      if(row + 1 < rows) {
+        if(column > 0) {
+          addCandidates(cell, cell + columns - 1);
+        }
+
+        addCandidates(cell, cell + columns);
+
+        if(column + 1 < columns) {
+          addCandidates(cell, cell + columns + 1);
+        }
+      }
+
+      testCandidates(pairs, NARROWPHASE_BATCH_SIZE);
+    }
+  }
+
+  testCandidates(pairs, 0);
+}
+
+void GridBroadphase::addCandidates(uint32_t cellA, uint32_t cellB) {
+  uint32_t beginA = m_cellStarts[cellA], endA = m_cellStarts[cellA + 1];
+  uint32_t beginB = m_cellStarts[cellB], endB = m_cellStarts[cellB + 1];
+
+  for(uint32_t a = beginA; a < endA; ++a) {
+    uint32_t layer = m_sortedLayers[a];
+    uint32_t mask = m_sortedMasks[a];
+
+    // NOTE(mizofix): a cell against itself, every pair is tested once
+    uint32_t b = (cellA == cellB) ? a + 1 : beginB;
+    for(; b < endB; ++b) {
+      if(!canCollide(layer, mask, m_sortedLayers[b], m_sortedMasks[b])) {
+        continue;
+      }
+
+      addCandidate(m_sortedBodies[a], m_sortedBodies[b]);
+    }
+  }
+}
+
+SweepAndPruneBroadphase::SweepAndPruneBroadphase(): m_axis(0) {
+
+}
+
+void SweepAndPruneBroadphase::findPairs(const BroadphaseBodies& bodies, std::vector<BroadphasePair>& pairs) {
+  pairs.clear();
+  m_pairTestsCount = 0;
+  packCircles(bodies, m_circles);
+
+  uint32_t bodiesCount = uint32_t(bodies.getSize());
+
+  // NOTE(mizofix): variances of the centers along the axes
+  double sumX = 0.0, sumY = 0.0, sumSquaredX = 0.0, sumSquaredY = 0.0;
+  uint32_t maxKey = 0;
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    sumX += bodies.x[i];
+    sumY += bodies.y[i];
+    sumSquaredX += double(bodies.x[i]) * bodies.x[i];
+    sumSquaredY += double(bodies.y[i]) * bodies.y[i];
+    maxKey = std::max(maxKey, bodies.keys[i]);
+  }
+
+  uint32_t axis = m_axis;
+  if(bodiesCount > 0) {
+    double varianceX = sumSquaredX - sumX * sumX / bodiesCount;
+    double varianceY = sumSquaredY - sumY * sumY / bodiesCount;
+    axis = (varianceY > varianceX) ? 1 : 0;
+  }
+
+  bool sortAnew = (axis != m_axis);
+  m_axis = axis;
+
+  const std::vector<real>& starts = (axis == 0) ? bodies.x : bodies.y;
+  const std::vector<real>& others = (axis == 0) ? bodies.y : bodies.x;
+
+  m_keyBodies.assign(std::size_t(maxKey) + 1, NO_BODY);
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    Assert(m_keyBodies[bodies.keys[i]] == NO_BODY);
+    m_keyBodies[bodies.keys[i]] = i;
+  }
+
+  m_takenBodies.assign(bodiesCount, 0);
+  m_sweepBodies.clear();
+
+  auto takeBody = [&](uint32_t body) {
+    real radius = bodies.radius[body];
+    m_sweepBodies.push_back(SweepBody{starts[body] - radius, starts[body] + radius,
+                                      others[body], radius,
+                                      bodies.layers[body], bodies.masks[body], body});
+    m_takenBodies[body] = 1;
+  };
+
+  // NOTE(mizofix): bodies of the last search in its order, then the new ones
+  for(uint32_t key: m_sortedKeys) {
+    if(key <= maxKey && m_keyBodies[key] != NO_BODY) {
+      takeBody(m_keyBodies[key]);
+    }
+  }
+
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    if(m_takenBodies[i] == 0) {
+      takeBody(i);
+    }
+  }
+
+  sortBodies(sortAnew);
+
+  m_sortedKeys.resize(bodiesCount);
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    m_sortedKeys[i] = bodies.keys[m_sweepBodies[i].body];
+  }
+
+  for(uint32_t a = 0; a < bodiesCount; ++a) {
+    const SweepBody& bodyA = m_sweepBodies[a];
+
+    for(uint32_t b = a + 1; b < bodiesCount && m_sweepBodies[b].start < bodyA.end; ++b) {
+      const SweepBody& bodyB = m_sweepBodies[b];
+
+      // NOTE(mizofix): a single test of the distance, which is almost always false,
+      // instead of the two ends of the intervals, which are true for about half
+      // of the bodies each and so can't be predicted
+      if(std::abs(bodyB.other - bodyA.other) >= bodyA.radius + bodyB.radius ||
+         !canCollide(bodyA.layer, bodyA.mask, bodyB.layer, bodyB.mask)) {
+        continue;
+      }
+
+      addCandidate(bodyA.body, bodyB.body);
+    }
+
+    testCandidates(pairs, NARROWPHASE_BATCH_SIZE);
+  }
+
+  testCandidates(pairs, 0);
+}
+
+void SweepAndPruneBroadphase::sortBodies(bool sortAnew) {
+  auto isLess = [](const SweepBody& bodyA, const SweepBody& bodyB) {
+    return bodyA.start < bodyB.start;
+  };
+
+  if(sortAnew) {
+    std::sort(m_sweepBodies.begin(), m_sweepBodies.end(), isLess);
+    return;
+  }
+
+  std::size_t movesCount = 0;
+  std::size_t maxMovesCount = m_sweepBodies.size() * SWEEP_MAX_MOVES_PER_BODY;
+
+  for(std::size_t i = 1; i < m_sweepBodies.size(); ++i) {
+    SweepBody body = m_sweepBodies[i];
+
+    std::size_t j = i;
+    for(; j > 0 && isLess(body, m_sweepBodies[j - 1]); --j) {
+      m_sweepBodies[j] = m_sweepBodies[j - 1];
+    }
+
+    m_sweepBodies[j] = body;
+
+    movesCount += i - j;
+    if(movesCount > maxMovesCount) {
+      std::sort(m_sweepBodies.begin(), m_sweepBodies.end(), isLess);
+      return;
+    }
+  }
+}
+
+// NOTE(mizofix): returns the number of tests
+static uint64_t findPairsBruteForce(const BroadphaseBodies& bodies, std::vector<BroadphasePair>& pairs) {
+  pairs.clear();
+  uint64_t testsCount = 0;
+
+  uint32_t bodiesCount = uint32_t(bodies.getSize());
+  for(uint32_t a = 0; a < bodiesCount; ++a) {
+    for(uint32_t b = a + 1; b < bodiesCount; ++b) {
+      if(!canCollide(bodies.layers[a], bodies.masks[a], bodies.layers[b], bodies.masks[b])) {
+        continue;
+      }
+
+      testsCount++;
+      if(isOverlapping(bodies.x[a], bodies.y[a], bodies.radius[a],
+                       bodies.x[b], bodies.y[b], bodies.radius[b])) {
+        pairs.push_back(BroadphasePair{a, b});
+      }
+    }
+  }
+
+  return testsCount;
+}
+
+static bool isSamePairs(std::vector<BroadphasePair> pairsA, std::vector<BroadphasePair> pairsB) {
+  sortPairs(pairsA);
+  sortPairs(pairsB);
+
+  return std::equal(pairsA.begin(), pairsA.end(), pairsB.begin(), pairsB.end(),
+                    [](const BroadphasePair& pairA, const BroadphasePair& pairB) {
+                      return pairA.a == pairB.a && pairA.b == pairB.b;
+                    });
+}
+
+// NOTE(mizofix): mostly zombies, some bullets and weapon boxes, sizes and layers are
+// the ones of the game. Clustered bodies are around the center as densely as zombies around
+// the player, a fifth of them is spread over the map
+static void generateBenchmarkBodies(Random& random, uint32_t bodiesCount, bool clustered,
+                                    real mapWidth, real mapHeight,
+                                    BroadphaseBodies& bodies, std::vector<vec2>& velocities) {
+  bodies.clear();
+  velocities.clear();
+
+  real clusterRadius = std::sqrt(real(bodiesCount) * 1200.0f / PI);
+
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    vec2 position;
+    if(clustered && random.nextInt(5) != 0) {
+      position = degToVec(random.nextReal(0.0f, 360.0f)) * (clusterRadius * std::sqrt(random.nextReal()));
+    } else {
+      position = vec2(random.nextReal(-mapWidth * 0.5f, mapWidth * 0.5f),
+                      random.nextReal(-mapHeight * 0.5f, mapHeight * 0.5f));
+    }
+
+    uint32_t kind = random.nextInt(10);
+    if(kind < 7) {
+      bodies.add(position.x, position.y, 15.0f * random.nextReal(0.8f, 1.2f), i, CollisionLayers::ZOMBIE,
+                 CollisionLayers::PLAYER | CollisionLayers::ZOMBIE | CollisionLayers::BULLET | CollisionLayers::MELEE);
+    } else if(kind < 9) {
+      bodies.add(position.x, position.y, 3.0f, i, CollisionLayers::BULLET, CollisionLayers::ZOMBIE);
+    } else {
+      bodies.add(position.x, position.y, 7.5f, i, CollisionLayers::PICKUP, CollisionLayers::PLAYER);
+    }
+
+    velocities.push_back(degToVec(random.nextReal(0.0f, 360.0f)) * random.nextReal(0.0f, 2.0f));
+  }
+}
+
+void runBroadphaseBenchmark(real mapWidth, real mapHeight, uint32_t seed) {
+  const uint32_t bodiesCounts[] = {250, 500, 1000, 2500, 5000, 10000, 20000};
+
+  // NOTE(mizofix): bodies move a bit (like in a tick) before every search, the
+  // first search isn't timed, so the sweep and prune has an order to start with
+  const uint32_t searchesCount = 10;
+
+  Random random(seed);
+  BroadphaseBodies bodies;
+  std::vector<vec2> velocities;
+  std::vector<BroadphasePair> brutePairs;
+  std::vector<BroadphasePair> pairs;
+
+  for(bool clustered: {false, true}) {
+    printf("%s bodies on %.0fx%.0f map:\n", clustered ? "clustered" : "spread", mapWidth, mapHeight);
+    printf("%8s %8s %14s %10s", "bodies", "pairs", "brute tests", "brute ms");
+    for(int type = 0; type < int(BroadphaseType::COUNT); ++type) {
+      printf(" %9s tests %8s ms", getBroadphaseName(BroadphaseType(type)), getBroadphaseName(BroadphaseType(type)));
+    }
+    printf("\n");
+
+    for(uint32_t bodiesCount: bodiesCounts) {
+      generateBenchmarkBodies(random, bodiesCount, clustered, mapWidth, mapHeight, bodies, velocities);
+
+      Broadphase* broadphases[int(BroadphaseType::COUNT)];
+      uint64_t times[int(BroadphaseType::COUNT)] = {};
+      uint64_t testsCounts[int(BroadphaseType::COUNT)] = {};
+      bool isCorrect = true;
+
+      for(int type = 0; type < int(BroadphaseType::COUNT); ++type) {
+        broadphases[type] = createBroadphase(BroadphaseType(type));
+      }
+
+      for(uint32_t search = 0; search <= searchesCount; ++search) {
+        for(uint32_t i = 0; i < bodiesCount; ++i) {
+          bodies.x[i] += velocities[i].x;
+          bodies.y[i] += velocities[i].y;
+        }
+
+        for(int type = 0; type < int(BroadphaseType::COUNT); ++type) {
+          uint64_t startTime = getProfilerTime();
+          broadphases[type]->findPairs(bodies, pairs);
+          uint64_t time = getProfilerTime() - startTime;
+
+          if(search > 0) {
+            times[type] += time;
+            testsCounts[type] += broadphases[type]->getPairTestsCount();
+          }
+        }
+      }
+
+      uint64_t startTime = getProfilerTime();
+      uint64_t bruteTestsCount = findPairsBruteForce(bodies, brutePairs);
+      uint64_t bruteTime = getProfilerTime() - startTime;
+
+      printf("%8u %8zu %14llu %10.3f", bodiesCount, brutePairs.size(),
+             (unsigned long long)bruteTestsCount, double(bruteTime) / 1000000.0);
+
+      for(int type = 0; type < int(BroadphaseType::COUNT); ++type) {
+        printf(" %15llu %11.3f", (unsigned long long)(testsCounts[type] / searchesCount),
+               double(times[type]) / searchesCount / 1000000.0);
+
+        broadphases[type]->findPairs(bodies, pairs);
+        isCorrect = isCorrect && isSamePairs(brutePairs, pairs);
+        delete broadphases[type];
+      }
+
+      printf("%s\n", isCorrect ? "" : " [error] pairs differ");
+    }
+  }
+}
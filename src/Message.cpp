@@ -1,53 +1,212 @@
 #include "Message.h"
-#include <list>
-#include <unordered_map>
+#include "Assert.h"
+#include "ecs/CommandBuffer.h"
+#include "Profiler.h"
 
-static std::list<Message> g_messageContainer;
-static std::unordered_map<int, std::list<MessageFunction>> g_subscribers;
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
 
-void addNewMessage(Message message) {
-  g_messageContainer.push_back(message);
+struct Subscriber {
+  void*           owner;
+  MessageFunction function;
+  uint32_t        id;
+};
 
+static std::vector<Subscriber> g_subscribers[int(MessageType::COUNT)];
+static uint32_t g_nextSubscriptionID = 1;
 
+// NOTE(mizofix): messages are sent from the worker threads as well
+static std::atomic<uint64_t> g_emittedCount[int(MessageType::COUNT)];
+static std::atomic<uint64_t> g_deliveredCount[int(MessageType::COUNT)];
+static std::atomic<uint64_t> g_handlersTime[int(MessageType::COUNT)];
+
+static MessageStats g_lastMessageStats[int(MessageType::COUNT)];
+static MessageStats g_frameMessageStats[int(MessageType::COUNT)];
+
+static FILE*    g_messageStatsFile = nullptr;
+static uint32_t g_messageStatsFrame = 0;
+
+Subscription subscribeToMessage(MessageType type, void* owner, MessageFunction function) {
+  Assert(type < MessageType::COUNT);
+
+  uint32_t id = g_nextSubscriptionID++;
+  g_subscribers[int(type)].push_back(Subscriber{owner, function, id});
+
+  return Subscription(type, id);
 }
 
-bool pollMessage(Message& message) {
-  if(peekMessage(message)) {
-    g_messageContainer.pop_front();
+void Subscription::reset() {
+  if(!isActive()) {
+    return;
+  }
 
-    return true;
+  // NOTE(mizofix): the order of the others is kept, they're notified in the order
+  // of subscription
+  std::vector<Subscriber>& subscribers = g_subscribers[int(m_type)];
+  auto subscriberIt = std::find_if(subscribers.begin(), subscribers.end(), [this](const Subscriber& subscriber) {
+    return subscriber.id == m_id;
+  });
+
+  Assert(subscriberIt != subscribers.end());
+  subscribers.erase(subscriberIt);
+
+  m_type = MessageType::COUNT;
+}
+
+static std::vector<MessageQueueBase*>& getMessageQueues() {
+  static std::vector<MessageQueueBase*> queues;
+  return queues;
+}
+
+// NOTE(mizofix): a queue is registered when it's used for the first time, which
+// may happen on any thread
+static std::mutex g_messageQueuesMutex;
+
+void registerMessageQueue(MessageQueueBase* queue) {
+  std::lock_guard<std::mutex> lock(g_messageQueuesMutex);
+  getMessageQueues().push_back(queue);
+}
+
+void swapMessageQueues() {
+  for(MessageQueueBase* queue: getMessageQueues()) {
+    queue->swap();
   }
+}
 
-  return false;
+void clearMessageQueues() {
+  for(MessageQueueBase* queue: getMessageQueues()) {
+    queue->clear();
+  }
 }
 
-bool peekMessage(Message& message) {
-  if(!g_messageContainer.empty()) {
-    message = g_messageContainer.front();
+static thread_local uint32_t t_messageBatch = 0;
 
-    return true;
+void setMessageBatch(uint32_t batch) {
+  t_messageBatch = batch;
+}
+
+uint32_t getMessageBatch() {
+  return t_messageBatch;
+}
+
+uint64_t getMessageKey() {
+  return (uint64_t(CommandBuffer::getProducer()) << 32) | t_messageBatch;
+}
+
+void countMessage(MessageType type) {
+  Assert(type < MessageType::COUNT);
+  g_emittedCount[int(type)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void countDeliveredMessages(MessageType type, uint64_t count) {
+  Assert(type < MessageType::COUNT);
+  g_deliveredCount[int(type)].fetch_add(count, std::memory_order_relaxed);
+}
+
+void notifySubscribers(MessageType type, const void* message) {
+  countMessage(type);
+
+  const std::vector<Subscriber>& subscribers = g_subscribers[int(type)];
+  if(subscribers.empty()) {
+    return;
   }
 
-  return false;
+  uint64_t startTime = getProfilerTime();
+  for(const Subscriber& subscriber: subscribers) {
+    subscriber.function(subscriber.owner, message);
+  }
+
+  g_handlersTime[int(type)].fetch_add(getProfilerTime() - startTime, std::memory_order_relaxed);
+  countDeliveredMessages(type, subscribers.size());
 }
 
-bool hasMessage() {
-  return !g_messageContainer.empty();
+bool hasSubscribers(MessageType type) {
+  Assert(type < MessageType::COUNT);
+  return !g_subscribers[int(type)].empty();
 }
 
-void subscribeToMessage(int message, MessageFunction function) {
-  g_subscribers[message].push_back(function);
+MessageStats getMessageStats(int type) {
+  Assert(type >= 0 && type < int(MessageType::COUNT));
+
+  MessageStats stats;
+  stats.emittedCount = g_emittedCount[type].load(std::memory_order_relaxed);
+  stats.deliveredCount = g_deliveredCount[type].load(std::memory_order_relaxed);
+  stats.handlersTime = g_handlersTime[type].load(std::memory_order_relaxed);
+  stats.subscribersCount = uint32_t(g_subscribers[type].size());
+
+  return stats;
 }
 
-void notify(Message message) {
-  auto subscribersIt = g_subscribers.find(message.type);
-  if(subscribersIt != g_subscribers.end()) {
-    for(auto subscriber: subscribersIt->second) {
-      subscriber(message);
+void updateMessageFrameStats() {
+  for(int type = 0; type < int(MessageType::COUNT); ++type) {
+    MessageStats stats = getMessageStats(type);
+    MessageStats& lastStats = g_lastMessageStats[type];
+    MessageStats& frameStats = g_frameMessageStats[type];
+
+    frameStats.emittedCount = stats.emittedCount - lastStats.emittedCount;
+    frameStats.deliveredCount = stats.deliveredCount - lastStats.deliveredCount;
+    frameStats.handlersTime = stats.handlersTime - lastStats.handlersTime;
+    frameStats.subscribersCount = stats.subscribersCount;
+    lastStats = stats;
+
+    if(frameStats.emittedCount == 0 && frameStats.deliveredCount == 0) {
+      continue;
+    }
+
+    recordProfilerCounter(getMessageTypeName(type), "messages", frameStats.emittedCount);
+
+    if(g_messageStatsFile != nullptr) {
+      fprintf(g_messageStatsFile, "%u,%s,%llu,%llu,%u,%.3f\n", g_messageStatsFrame, getMessageTypeName(type),
+              (unsigned long long)frameStats.emittedCount, (unsigned long long)frameStats.deliveredCount,
+              frameStats.subscribersCount, double(frameStats.handlersTime) / 1000.0);
     }
   }
+
+  g_messageStatsFrame++;
 }
 
-void clearSubscribers() {
-  g_subscribers.clear();
+const MessageStats& getMessageFrameStats(int type) {
+  Assert(type >= 0 && type < int(MessageType::COUNT));
+  return g_frameMessageStats[type];
+}
+
+bool openMessageStatsFile(const char* path) {
+  Assert(g_messageStatsFile == nullptr);
+
+  g_messageStatsFile = fopen(path, "w");
+  if(g_messageStatsFile == nullptr) {
+    return false;
+  }
+
+  // NOTE(mizofix): the time is in microseconds
+  fprintf(g_messageStatsFile, "frame,type,emitted,delivered,subscribers,handlers_time\n");
+  return true;
+}
+
+bool closeMessageStatsFile() {
+  if(g_messageStatsFile == nullptr) {
+    return true;
+  }
+
+  bool result = (fclose(g_messageStatsFile) == 0);
+  g_messageStatsFile = nullptr;
+
+  return result;
+}
+
+const char* getMessageTypeName(int type) {
+  switch(MessageType(type)) {
+  case MessageType::PLAYER_DEAD: return "PLAYER_DEAD";
+  case MessageType::SPAWN_EFFECT: return "SPAWN_EFFECT";
+  case MessageType::ZOMBIE_ATTACK: return "ZOMBIE_ATTACK";
+  case MessageType::ECS_ENTITY_DELETE: return "ECS_ENTITY_DELETE";
+  case MessageType::ECS_ENTITIES_DELETE: return "ECS_ENTITIES_DELETE";
+  case MessageType::ECS_ENTITY_CREATED: return "ECS_ENTITY_CREATED";
+  case MessageType::ON_MOUSE_WHEEL: return "ON_MOUSE_WHEEL";
+  case MessageType::ON_COLLISION: return "ON_COLLISION";
+  default: return "UNKNOWN";
+  }
 }
@@ -0,0 +1,358 @@
+#include "Narrowphase.h"
+#include "Assert.h"
+#include "Broadphase.h"
+#include "Profiler.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// NOTE(mizofix): SSE2 and AVX2 functions are compiled for their targets and are
+// called only when the CPU has them, so the rest of the program is built for any x86
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define NARROWPHASE_X86
+  #include <immintrin.h>
+#endif
+
+// NOTE(mizofix): every candidate is written, but the end moves only past the
+// overlapping ones, so there are no branches which the CPU could mispredict.
+// Returns the number of contacts
+static std::size_t testScalar(const NarrowphaseCircle* circles,
+                              const BroadphasePair* candidates, std::size_t candidatesCount,
+                              BroadphasePair* contacts) {
+  std::size_t contactsCount = 0;
+  for(std::size_t i = 0; i < candidatesCount; ++i) {
+    const NarrowphaseCircle& circleA = circles[candidates[i].a];
+    const NarrowphaseCircle& circleB = circles[candidates[i].b];
+
+    real dx = circleB.x - circleA.x;
+    real dy = circleB.y - circleA.y;
+    real sumRadius = circleA.radius + circleB.radius;
+
+    contacts[contactsCount] = candidates[i];
+    contactsCount += (dx * dx + dy * dy < sumRadius * sumRadius) ? 1 : 0;
+  }
+
+  return contactsCount;
+}
+
+#ifdef NARROWPHASE_X86
+
+// NOTE(mizofix): the stores of testScalar() for 4 pairs of a mask
+static inline std::size_t storeContacts(const BroadphasePair* pairs, uint32_t mask, BroadphasePair* contacts) {
+  std::size_t contactsCount = 0;
+  contacts[contactsCount] = pairs[0];
+  contactsCount += mask & 1;
+  contacts[contactsCount] = pairs[1];
+  contactsCount += (mask >> 1) & 1;
+  contacts[contactsCount] = pairs[2];
+  contactsCount += (mask >> 2) & 1;
+  contacts[contactsCount] = pairs[3];
+  contactsCount += (mask >> 3) & 1;
+
+  return contactsCount;
+}
+
+// NOTE(mizofix): a circle is loaded at once, 4 of them are transposed into lanes
+// of x, y and radius
+__attribute__((target("sse2")))
+static std::size_t testSSE2(const NarrowphaseCircle* circles,
+                            const BroadphasePair* candidates, std::size_t candidatesCount,
+                            BroadphasePair* contacts) {
+  std::size_t contactsCount = 0;
+  std::size_t i = 0;
+
+  for(; i + 4 <= candidatesCount; i += 4) {
+    const BroadphasePair* pairs = candidates + i;
+
+    __m128 xA = _mm_load_ps(&circles[pairs[0].a].x);
+    __m128 yA = _mm_load_ps(&circles[pairs[1].a].x);
+    __m128 radiusA = _mm_load_ps(&circles[pairs[2].a].x);
+    __m128 unusedA = _mm_load_ps(&circles[pairs[3].a].x);
+    _MM_TRANSPOSE4_PS(xA, yA, radiusA, unusedA);
+
+    __m128 xB = _mm_load_ps(&circles[pairs[0].b].x);
+    __m128 yB = _mm_load_ps(&circles[pairs[1].b].x);
+    __m128 radiusB = _mm_load_ps(&circles[pairs[2].b].x);
+    __m128 unusedB = _mm_load_ps(&circles[pairs[3].b].x);
+    _MM_TRANSPOSE4_PS(xB, yB, radiusB, unusedB);
+
+    __m128 dx = _mm_sub_ps(xB, xA);
+    __m128 dy = _mm_sub_ps(yB, yA);
+    __m128 sumRadius = _mm_add_ps(radiusA, radiusB);
+    __m128 overlaps = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                   _mm_mul_ps(sumRadius, sumRadius));
+
+    contactsCount += storeContacts(pairs, uint32_t(_mm_movemask_ps(overlaps)), contacts + contactsCount);
+  }
+
+  return contactsCount + testScalar(circles, candidates + i, candidatesCount - i, contacts + contactsCount);
+}
+
+// NOTE(mizofix): the circle of the pair k goes to the low half of the row k, the
+// circle of the pair k + 4 - to the high half
+__attribute__((target("avx2"), always_inline))
+static inline __m256 loadRow(const NarrowphaseCircle* circles, uint32_t lowCircle, uint32_t highCircle) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(&circles[lowCircle].x)),
+                              _mm_load_ps(&circles[highCircle].x), 1);
+}
+
+// NOTE(mizofix): halves of the rows are transposed as in SSE2, so lane k is the
+// circle of the pair k
+__attribute__((target("avx2"), always_inline))
+static inline void transposeRows(__m256 row0, __m256 row1, __m256 row2, __m256 row3,
+                                 __m256& x, __m256& y, __m256& radius) {
+  __m256 low01 = _mm256_unpacklo_ps(row0, row1);
+  __m256 low23 = _mm256_unpacklo_ps(row2, row3);
+  __m256 high01 = _mm256_unpackhi_ps(row0, row1);
+  __m256 high23 = _mm256_unpackhi_ps(row2, row3);
+
+  x = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(1, 0, 1, 0));
+  y = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(3, 2, 3, 2));
+  radius = _mm256_shuffle_ps(high01, high23, _MM_SHUFFLE(1, 0, 1, 0));
+}
+
+// NOTE(mizofix): for every mask of 4 pairs, indices of the dwords (a pair is two of
+// them) which move the pairs of the mask to the front, and the number of the pairs
+struct CompressTable {
+  constexpr CompressTable(): indices(), counts() {
+    for(uint32_t mask = 0; mask < 16; ++mask) {
+      for(uint32_t lane = 0; lane < 4; ++lane) {
+        if((mask >> lane) & 1) {
+          indices[mask][counts[mask] * 2] = lane * 2;
+          indices[mask][counts[mask] * 2 + 1] = lane * 2 + 1;
+          counts[mask]++;
+        }
+      }
+    }
+  }
+
+  alignas(32) uint32_t indices[16][8];
+  uint32_t             counts[16];
+};
+
+static constexpr CompressTable COMPRESS_TABLE;
+
+// NOTE(mizofix): all 4 pairs are stored, the overlapping ones first. Candidates
+// before them took at least as many places, so the store stays in the contacts
+__attribute__((target("avx2"), always_inline))
+static inline std::size_t compressPairs(__m256i pairs, uint32_t mask, BroadphasePair* contacts) {
+  __m256i indices = _mm256_load_si256((const __m256i*)COMPRESS_TABLE.indices[mask]);
+  _mm256_storeu_si256((__m256i*)contacts, _mm256_permutevar8x32_epi32(pairs, indices));
+
+  return COMPRESS_TABLE.counts[mask];
+}
+
+__attribute__((target("avx2")))
+static std::size_t testAVX2(const NarrowphaseCircle* circles,
+                            const BroadphasePair* candidates, std::size_t candidatesCount,
+                            BroadphasePair* contacts) {
+  std::size_t contactsCount = 0;
+  std::size_t i = 0;
+
+  for(; i + 8 <= candidatesCount; i += 8) {
+    const BroadphasePair* pairs = candidates + i;
+    __m256i lowPairs = _mm256_loadu_si256((const __m256i*)pairs);
+    __m256i highPairs = _mm256_loadu_si256((const __m256i*)(pairs + 4));
+
+    __m256 xA, yA, radiusA;
+    transposeRows(loadRow(circles, pairs[0].a, pairs[4].a), loadRow(circles, pairs[1].a, pairs[5].a),
+                  loadRow(circles, pairs[2].a, pairs[6].a), loadRow(circles, pairs[3].a, pairs[7].a),
+                  xA, yA, radiusA);
+
+    __m256 xB, yB, radiusB;
+    transposeRows(loadRow(circles, pairs[0].b, pairs[4].b), loadRow(circles, pairs[1].b, pairs[5].b),
+                  loadRow(circles, pairs[2].b, pairs[6].b), loadRow(circles, pairs[3].b, pairs[7].b),
+                  xB, yB, radiusB);
+
+    __m256 dx = _mm256_sub_ps(xB, xA);
+    __m256 dy = _mm256_sub_ps(yB, yA);
+    __m256 sumRadius = _mm256_add_ps(radiusA, radiusB);
+    __m256 overlaps = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+                                    _mm256_mul_ps(sumRadius, sumRadius), _CMP_LT_OQ);
+
+    uint32_t mask = uint32_t(_mm256_movemask_ps(overlaps));
+    contactsCount += compressPairs(lowPairs, mask & 15, contacts + contactsCount);
+    contactsCount += compressPairs(highPairs, mask >> 4, contacts + contactsCount);
+  }
+
+  return contactsCount + testScalar(circles, candidates + i, candidatesCount - i, contacts + contactsCount);
+}
+
+#endif
+
+bool isNarrowphaseSupported(NarrowphaseType type) {
+  switch(type) {
+  case NarrowphaseType::SCALAR: return true;
+#ifdef NARROWPHASE_X86
+  case NarrowphaseType::SSE2: return __builtin_cpu_supports("sse2");
+  case NarrowphaseType::AVX2: return __builtin_cpu_supports("avx2");
+#endif
+  default: return false;
+  }
+}
+
+NarrowphaseType getBestNarrowphase() {
+  static const NarrowphaseType bestType = []() {
+    for(int type = int(NarrowphaseType::COUNT) - 1; type > 0; --type) {
+      if(isNarrowphaseSupported(NarrowphaseType(type))) {
+        return NarrowphaseType(type);
+      }
+    }
+
+    return NarrowphaseType::SCALAR;
+  }();
+
+  return bestType;
+}
+
+const char* getNarrowphaseName(NarrowphaseType type) {
+  switch(type) {
+  case NarrowphaseType::SCALAR: return "scalar";
+  case NarrowphaseType::SSE2: return "sse2";
+  case NarrowphaseType::AVX2: return "avx2";
+  default: return "unknown";
+  }
+}
+
+void packCircles(const BroadphaseBodies& bodies, std::vector<NarrowphaseCircle>& circles) {
+  circles.resize(bodies.getSize());
+  for(std::size_t i = 0; i < circles.size(); ++i) {
+    circles[i] = NarrowphaseCircle{bodies.x[i], bodies.y[i], bodies.radius[i], 0.0f};
+  }
+}
+
+std::size_t findContacts(NarrowphaseType type, const NarrowphaseCircle* circles,
+                         const BroadphasePair* candidates, std::size_t candidatesCount,
+                         BroadphasePair* contacts) {
+  Assert(isNarrowphaseSupported(type));
+
+  switch(type) {
+#ifdef NARROWPHASE_X86
+  case NarrowphaseType::SSE2: return testSSE2(circles, candidates, candidatesCount, contacts);
+  case NarrowphaseType::AVX2: return testAVX2(circles, candidates, candidatesCount, contacts);
+#endif
+  default: return testScalar(circles, candidates, candidatesCount, contacts);
+  }
+}
+
+bool findTimeOfImpact(const vec2& offset, const vec2& motion, real radius, real& time) {
+  // NOTE(mizofix): |offset + motion * t| = radius, the earlier root is the time
+  real c = offset.sqLength() - radius * radius;
+  if(c < 0.0f) {
+    time = 0.0f;
+    return true;
+  }
+
+  real b = offset.dot(motion);
+  if(b >= 0.0f) {
+    // NOTE(mizofix): the body doesn't move (motion is zero) or moves away
+    return false;
+  }
+
+  real a = motion.sqLength();
+  real discriminant = b * b - a * c;
+  if(discriminant < 0.0f) {
+    return false;
+  }
+
+  real root = (-b - std::sqrt(discriminant)) / a;
+  if(root > 1.0f) {
+    return false;
+  }
+
+  time = root;
+  return true;
+}
+
+// NOTE(mizofix): bodies are spread so that a body has about a hundred others in
+// the square of two grid cells around it, like in a dense crowd of zombies. Indices
+// of the bodies don't follow their positions, like indices of entities
+static void generateBenchmarkCandidates(Random& random, uint32_t bodiesCount, real mapSize,
+                                        BroadphaseBodies& bodies, std::vector<BroadphasePair>& candidates) {
+  const real maxRadius = 18.0f;
+
+  bodies.clear();
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    bodies.add(random.nextReal(0.0f, mapSize), random.nextReal(0.0f, mapSize),
+               15.0f * random.nextReal(0.8f, 1.2f), i);
+  }
+
+  std::vector<uint32_t> order(bodiesCount);
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    order[i] = i;
+  }
+
+  std::sort(order.begin(), order.end(), [&bodies](uint32_t bodyA, uint32_t bodyB) {
+    return bodies.x[bodyA] < bodies.x[bodyB];
+  });
+
+  candidates.clear();
+  for(uint32_t i = 0; i < bodiesCount; ++i) {
+    uint32_t a = order[i];
+    for(uint32_t j = i + 1; j < bodiesCount && bodies.x[order[j]] - bodies.x[a] < maxRadius * 2.0f; ++j) {
+      uint32_t b = order[j];
+      if(std::abs(bodies.y[b] - bodies.y[a]) < maxRadius * 2.0f) {
+        candidates.push_back(BroadphasePair{std::min(a, b), std::max(a, b)});
+      }
+    }
+  }
+}
+
+void runNarrowphaseBenchmark(uint32_t seed) {
+  const uint32_t bodiesCount = 20000;
+  const uint32_t runsCount = 20;
+
+  Random random(seed);
+  BroadphaseBodies bodies;
+  std::vector<BroadphasePair> candidates;
+  generateBenchmarkCandidates(random, bodiesCount, 1000.0f, bodies, candidates);
+
+  std::vector<NarrowphaseCircle> circles;
+  packCircles(bodies, circles);
+
+  std::vector<BroadphasePair> scalarContacts(candidates.size());
+  scalarContacts.resize(findContacts(NarrowphaseType::SCALAR, circles.data(), candidates.data(),
+                                     candidates.size(), scalarContacts.data()));
+
+  printf("narrowphase, %u bodies, %zu candidates, %zu contacts:\n", bodiesCount,
+         candidates.size(), scalarContacts.size());
+  printf("%8s %14s %8s\n", "type", "ms per 1M", "speedup");
+
+  double scalarTime = 0.0;
+  std::vector<BroadphasePair> contacts(candidates.size());
+  for(int type = 0; type < int(NarrowphaseType::COUNT); ++type) {
+    if(!isNarrowphaseSupported(NarrowphaseType(type))) {
+      printf("%8s %14s\n", getNarrowphaseName(NarrowphaseType(type)), "unsupported");
+      continue;
+    }
+
+    // NOTE(mizofix): in batches, like the broadphase passes them
+    std::size_t contactsCount = 0;
+    uint64_t startTime = getProfilerTime();
+    for(uint32_t run = 0; run < runsCount; ++run) {
+      contactsCount = 0;
+      for(std::size_t start = 0; start < candidates.size(); start += NARROWPHASE_BATCH_SIZE) {
+        std::size_t count = std::min(NARROWPHASE_BATCH_SIZE, candidates.size() - start);
+        contactsCount += findContacts(NarrowphaseType(type), circles.data(), candidates.data() + start,
+                                      count, contacts.data() + contactsCount);
+      }
+    }
+
+    double time = double(getProfilerTime() - startTime) / runsCount / 1000000.0 *
+                  (1000000.0 / double(std::max<std::size_t>(candidates.size(), 1)));
+    if(type == int(NarrowphaseType::SCALAR)) {
+      scalarTime = time;
+    }
+
+    bool isCorrect = std::equal(contacts.begin(), contacts.begin() + contactsCount,
+                                scalarContacts.begin(), scalarContacts.end(),
+                                [](const BroadphasePair& pairA, const BroadphasePair& pairB) {
+                                  return pairA.a == pairB.a && pairA.b == pairB.b;
+                                });
+
+    printf("%8s %14.3f %7.2fx%s\n", getNarrowphaseName(NarrowphaseType(type)), time,
+           scalarTime / time, isCorrect ? "" : " [error] contacts differ");
+  }
+}
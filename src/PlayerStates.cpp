@@ -4,8 +4,8 @@
 #include "Message.h"
 
 void PlayerIdle::onEnter(ECSContext& context, Entity player) {
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
 
   WeaponType currentWeapon = playerComponent->weapons[playerComponent->currentWeaponIndex].type;
   if(currentWeapon == WeaponType::KNIFE) {
@@ -26,9 +26,9 @@ void PlayerIdle::onEnter(ECSContext& context, Entity player) {
 
 void PlayerIdle::update(ECSContext& context, Entity player, real deltaTime) {
   // if player began movement -> switch to moving
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
-  Physics* physics = context.registry->getComponent<Physics>(player, ComponentID::Physics);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
+  Physics* physics = context.registry->getComponent<Physics>(player);
 
   updateAnimation(model->sprite, deltaTime);
 
@@ -53,8 +53,8 @@ void PlayerIdle::update(ECSContext& context, Entity player, real deltaTime) {
 }
 
 void PlayerMove::onEnter(ECSContext& context, Entity player) {
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
 
   WeaponType currentWeapon = playerComponent->weapons[playerComponent->currentWeaponIndex].type;
   if(currentWeapon == WeaponType::KNIFE) {
@@ -72,9 +72,9 @@ void PlayerMove::onEnter(ECSContext& context, Entity player) {
 }
 
 void PlayerMove::update(ECSContext& context, Entity player, real deltaTime) {
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
-  Physics* physics = context.registry->getComponent<Physics>(player, ComponentID::Physics);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
+  Physics* physics = context.registry->getComponent<Physics>(player);
 
   updateAnimation(model->sprite, deltaTime);
 
@@ -99,8 +99,8 @@ void PlayerMove::update(ECSContext& context, Entity player, real deltaTime) {
 }
 
 void PlayerShoot::onEnter(ECSContext& context, Entity player) {
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
 
   WeaponData currentWeapon = playerComponent->weapons[playerComponent->currentWeaponIndex];
 
@@ -125,15 +125,14 @@ void PlayerShoot::onEnter(ECSContext& context, Entity player) {
 
 void PlayerShoot::update(ECSContext& context, Entity player, real deltaTime) {
 
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
-  Physics* physics = context.registry->getComponent<Physics>(player, ComponentID::Physics);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
+  Physics* physics = context.registry->getComponent<Physics>(player);
 
   updateAnimation(model->sprite, deltaTime);
   if(isAnimationFinished(model->sprite)) {
 
-    Transformation* transf = context.registry->getComponent<Transformation>(player,
-                                                                            ComponentID::Transformation);
+    Transformation* transf = context.registry->getComponent<Transformation>(player);
 
     vec2 offset = playerComponent->weapons[playerComponent->currentWeaponIndex].handOffset;
     vec2 playerHeading = degToVec(transf->angle);
@@ -178,49 +177,47 @@ Entity PlayerShoot::generateBullet(Registry* registry,
                                    const vec2& direction, const vec2& position,
                                    const WeaponData& data) {
 
-  Entity bullet = registry->createEntity();
-  Physics* physics = new Physics();
+  Entity bullet = registry->createEntity(buildBitfield(ComponentID::Physics,
+                                                      ComponentID::Transformation,
+                                                      ComponentID::Bullet));
+
+  Physics* physics = registry->getComponent<Physics>(bullet);
   physics->velocity = direction * data.speed;
   physics->size = data.bulletSize;
   physics->maxSpeed = data.speed;
+  physics->collisionLayer = CollisionLayers::BULLET;
+  physics->collisionMask = CollisionLayers::ZOMBIE;
 
-  Transformation* transformation = new Transformation();
+  Transformation* transformation = registry->getComponent<Transformation>(bullet);
   transformation->position = position;
   transformation->angle = vecToDeg(direction);
 
-  Bullet* bulletComponent = new Bullet();
+  Bullet* bulletComponent = registry->getComponent<Bullet>(bullet);
   bulletComponent->lifetime = data.lifetime;
   bulletComponent->durability = data.durability;
   bulletComponent->damage = data.damage;
 
-  registry->addComponent(bullet, physics);
-  registry->addComponent(bullet, transformation);
-  registry->addComponent(bullet, bulletComponent);
-
-  Entity trail = registry->createEntity();
-  Trail* trailComp = new Trail(bullet,
-                               data.trailLifetime,
-                               data.trailMaxAngle,
-                               data.trailScatterSpeed,
-                               data.bulletSize);
-
-  registry->addComponent(trail, trailComp);
+  Entity trail = registry->createEntity(buildBitfield(ComponentID::Trail));
+  Trail* trailComp = registry->getComponent<Trail>(trail);
+  trailComp->target = bullet;
+  trailComp->lifetime = data.trailLifetime;
+  trailComp->maxRandomAngle = data.trailMaxAngle;
+  trailComp->maxSpeed = data.trailScatterSpeed;
+  trailComp->size = data.bulletSize;
 
   return bullet;
 }
 
 void PlayerShoot::generateExplosion(const vec2& position, real angle) {
-  Message msg;
-  msg.type = int(MessageType::SPAWN_EFFECT);
-  msg.effect_info.type = EffectType::GUN_EXPLOSION;
-  msg.effect_info.x = position.x;
-  msg.effect_info.y = position.y;
-  msg.effect_info.scale = 1.0f;
-  msg.effect_info.angle = angle;
-  msg.effect_info.lifetime = 5.0f;
-  msg.effect_info.fadeOut = false;
-
-  notify(msg);
+  SpawnEffectMessage msg;
+  msg.type = EffectType::GUN_EXPLOSION;
+  msg.position = position;
+  msg.scale = 1.0f;
+  msg.angle = angle;
+  msg.lifetime = 5.0f;
+  msg.fadeOut = false;
+
+  post(msg);
 }
 
 bool PlayerShoot::needToReload(Player* player) {
@@ -235,9 +232,9 @@ bool PlayerShoot::hasAvailableAmmo(Player* player) {
 }
 
 void PlayerAttack::onEnter(ECSContext& context, Entity player) {
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Transformation* transf = context.registry->getComponent<Transformation>(player, ComponentID::Transformation);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
+  Model* model = context.registry->getComponent<Model>(player);
+  Transformation* transf = context.registry->getComponent<Transformation>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
 
   WeaponData currentWeapon = playerComponent->weapons[playerComponent->currentWeaponIndex];
 
@@ -266,8 +263,8 @@ void PlayerAttack::onEnter(ECSContext& context, Entity player) {
 
 void PlayerAttack::update(ECSContext& context, Entity player, real deltaTime) {
 
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Physics* physics = context.registry->getComponent<Physics>(player, ComponentID::Physics);
+  Model* model = context.registry->getComponent<Model>(player);
+  Physics* physics = context.registry->getComponent<Physics>(player);
 
   updateAnimation(model->sprite, deltaTime);
 
@@ -292,32 +289,32 @@ void PlayerAttack::generateAttack(Registry* registry,
                                   real angle, const vec2& position,
                                   real damage) {
 
-  Entity attackPart = registry->createEntity();
+  Entity attackPart = registry->createEntity(buildBitfield(ComponentID::Physics,
+                                                          ComponentID::Transformation,
+                                                          ComponentID::Bullet));
 
-  Physics* physics = new Physics();
+  Physics* physics = registry->getComponent<Physics>(attackPart);
   physics->velocity = degToVec(angle) * 500.0f;
   physics->size = 3.0f;
   physics->maxSpeed = 500.0f;
+  physics->collisionLayer = CollisionLayers::MELEE;
+  physics->collisionMask = CollisionLayers::ZOMBIE;
 
-  Transformation* transformation = new Transformation();
+  Transformation* transformation = registry->getComponent<Transformation>(attackPart);
   transformation->position = position;
   transformation->angle = 0.0f;
 
-  Bullet* bulletComponent = new Bullet();
+  Bullet* bulletComponent = registry->getComponent<Bullet>(attackPart);
   bulletComponent->lifetime = 0.1;
   bulletComponent->durability = 1;
   bulletComponent->damage = damage;
 
-  registry->addComponent(attackPart, physics);
-  registry->addComponent(attackPart, transformation);
-  registry->addComponent(attackPart, bulletComponent);
-
 }
 
 
 void PlayerReload::onEnter(ECSContext& context, Entity player) {
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
 
   WeaponData currentWeapon = playerComponent->weapons[playerComponent->currentWeaponIndex];
 
@@ -337,9 +334,9 @@ void PlayerReload::onEnter(ECSContext& context, Entity player) {
 
 void PlayerReload::update(ECSContext& context, Entity player, real deltaTime) {
 
-  Model* model = context.registry->getComponent<Model>(player, ComponentID::Model);
-  Player* playerComponent = context.registry->getComponent<Player>(player, ComponentID::Player);
-  Physics* physics = context.registry->getComponent<Physics>(player, ComponentID::Physics);
+  Model* model = context.registry->getComponent<Model>(player);
+  Player* playerComponent = context.registry->getComponent<Player>(player);
+  Physics* physics = context.registry->getComponent<Physics>(player);
 
   updateAnimation(model->sprite, deltaTime);
   if(isAnimationFinished(model->sprite)) {
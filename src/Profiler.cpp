@@ -0,0 +1,115 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+static_assert((PROFILER_EVENTS_COUNT & (PROFILER_EVENTS_COUNT - 1)) == 0,
+              "PROFILER_EVENTS_COUNT must be a power of two");
+
+// NOTE(mizofix): sequence is the number of the event in the slot plus one, it's
+// published after the event is written. A slot which is being rewritten has
+// a different sequence, so the dump can skip it
+struct ProfilerSlot {
+  ProfilerEvent         event;
+  std::atomic<uint64_t> sequence;
+};
+
+static const std::chrono::steady_clock::time_point g_profilerStartTime = std::chrono::steady_clock::now();
+
+static ProfilerSlot g_profilerSlots[PROFILER_EVENTS_COUNT];
+static std::atomic<uint64_t> g_profilerNextEvent(0);
+static std::atomic<uint32_t> g_profilerNextThread(0);
+
+static uint32_t getProfilerThread() {
+  static thread_local uint32_t thread = g_profilerNextThread.fetch_add(1, std::memory_order_relaxed);
+  return thread;
+}
+
+uint64_t getProfilerTime() {
+  std::chrono::steady_clock::duration time = std::chrono::steady_clock::now() - g_profilerStartTime;
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+// NOTE(mizofix): nodes of the set never move, so pointers to the names stay valid
+static std::set<std::string> g_profilerNames;
+static std::mutex g_profilerNamesMutex;
+
+const char* internProfilerName(const char* name) {
+  std::lock_guard<std::mutex> lock(g_profilerNamesMutex);
+  return g_profilerNames.insert(name).first->c_str();
+}
+
+static void recordEvent(const char* name, const char* category, uint64_t start, uint64_t duration,
+                        char phase) {
+  uint64_t number = g_profilerNextEvent.fetch_add(1, std::memory_order_relaxed);
+  ProfilerSlot& slot = g_profilerSlots[number & (PROFILER_EVENTS_COUNT - 1)];
+
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.event.name = name;
+  slot.event.category = category;
+  slot.event.start = start;
+  slot.event.duration = duration;
+  slot.event.thread = getProfilerThread();
+  slot.event.phase = phase;
+
+  slot.sequence.store(number + 1, std::memory_order_release);
+}
+
+void recordProfilerEvent(const char* name, const char* category, uint64_t start, uint64_t end) {
+  recordEvent(name, category, start, end - start, 'X');
+}
+
+void recordProfilerCounter(const char* name, const char* category, uint64_t value) {
+  recordEvent(name, category, getProfilerTime(), value, 'C');
+}
+
+bool dumpProfilerTrace(const char* path) {
+  uint64_t lastEvent = g_profilerNextEvent.load(std::memory_order_acquire);
+  uint64_t firstEvent = (lastEvent > PROFILER_EVENTS_COUNT) ? lastEvent - PROFILER_EVENTS_COUNT : 0;
+
+  std::vector<ProfilerEvent> events;
+  events.reserve(lastEvent - firstEvent);
+  for(uint64_t number = firstEvent; number < lastEvent; ++number) {
+    ProfilerSlot& slot = g_profilerSlots[number & (PROFILER_EVENTS_COUNT - 1)];
+    if(slot.sequence.load(std::memory_order_acquire) != number + 1) {
+      continue;
+    }
+
+    ProfilerEvent event = slot.event;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(slot.sequence.load(std::memory_order_relaxed) == number + 1) {
+      events.push_back(event);
+    }
+  }
+
+  FILE* file = fopen(path, "w");
+  if(file == nullptr) {
+    return false;
+  }
+
+  // NOTE(mizofix): timestamps of the trace format are in microseconds
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for(std::size_t i = 0; i < events.size(); ++i) {
+    const ProfilerEvent& event = events[i];
+    const char* separator = (i + 1 < events.size()) ? "," : "";
+    if(event.phase == 'C') {
+      fprintf(file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":0,\"args\":{\"value\":%llu}}%s\n",
+              event.name, event.category, double(event.start) / 1000.0,
+              (unsigned long long)event.duration, separator);
+    } else {
+      fprintf(file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}%s\n",
+              event.name, event.category, double(event.start) / 1000.0, double(event.duration) / 1000.0,
+              event.thread, separator);
+    }
+  }
+  fprintf(file, "]}\n");
+
+  return fclose(file) == 0;
+}
@@ -0,0 +1,24 @@
+#include "Random.h"
+#include "Assert.h"
+
+static uint64_t g_randomSeed = 0;
+static Random   g_randomStreams[std::size_t(RandomStream::COUNT)];
+
+void seedRandom(uint64_t seed) {
+  g_randomSeed = seed;
+  for(std::size_t stream = 0; stream < std::size_t(RandomStream::COUNT); ++stream) {
+    g_randomStreams[stream].setSeed(seed, stream);
+  }
+}
+
+Random& getRandom(RandomStream stream) {
+  Assert(stream < RandomStream::COUNT);
+  return g_randomStreams[std::size_t(stream)];
+}
+
+Random makeRandom(RandomStream stream, uint64_t substream) {
+  Assert(stream < RandomStream::COUNT);
+
+  // NOTE(mizofix): the first stream numbers belong to getRandom()
+  return Random(g_randomSeed, (substream + 1) * uint64_t(RandomStream::COUNT) + uint64_t(stream));
+}
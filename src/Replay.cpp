@@ -0,0 +1,139 @@
+#include "Replay.h"
+#include "Assert.h"
+
+#include <cstring>
+
+const static char     REPLAY_MAGIC[4] = {'C', 'R', 'R', 'P'};
+const static uint32_t REPLAY_VERSION = 1;
+
+// NOTE(mizofix): structures are written as they are, so they shouldn't have padding
+static_assert(sizeof(ReplayHeader) == 14 * 4, "ReplayHeader has padding");
+static_assert(sizeof(ReplayFrame) == 12, "ReplayFrame has padding");
+
+ReplayHeader makeReplayHeader(const WorldData& data) {
+  ReplayHeader header;
+  header.seed = data.seed;
+  header.simulationRate = data.simulationRate;
+  header.windowWidth = data.windowWidth;
+  header.windowHeight = data.windowHeight;
+  header.mapWidth = data.mapWidth;
+  header.mapHeight = data.mapHeight;
+  header.numEnemies = data.numEnemies;
+  header.numPlants = data.numPlants;
+  header.maxPlayerHealth = data.maxPlayerHealth;
+  header.maxPlayerStamina = data.maxPlayerStamina;
+  header.regenSpeed = data.regenSpeed;
+  header.staminaRegenSpeed = data.staminaRegenSpeed;
+  header.maxEffectsNumber = data.maxEffectsNumber;
+  header.startRound = data.roundData.currentRoundNumber;
+
+  return header;
+}
+
+void applyReplayHeader(const ReplayHeader& header, WorldData& data) {
+  data.seed = header.seed;
+  data.simulationRate = header.simulationRate;
+  data.windowWidth = header.windowWidth;
+  data.windowHeight = header.windowHeight;
+  data.mapWidth = header.mapWidth;
+  data.mapHeight = header.mapHeight;
+  data.numEnemies = header.numEnemies;
+  data.numPlants = header.numPlants;
+  data.maxPlayerHealth = header.maxPlayerHealth;
+  data.maxPlayerStamina = header.maxPlayerStamina;
+  data.regenSpeed = header.regenSpeed;
+  data.staminaRegenSpeed = header.staminaRegenSpeed;
+  data.maxEffectsNumber = header.maxEffectsNumber;
+  data.roundData.currentRoundNumber = header.startRound;
+}
+
+ReplayWriter::ReplayWriter(): m_file(nullptr) { }
+
+ReplayWriter::~ReplayWriter() {
+  close();
+}
+
+bool ReplayWriter::open(const char* path, const ReplayHeader& header) {
+  Assert(m_file == nullptr);
+
+  m_file = fopen(path, "wb");
+  if(m_file == nullptr) {
+    return false;
+  }
+
+  if(fwrite(REPLAY_MAGIC, sizeof(REPLAY_MAGIC), 1, m_file) != 1 ||
+     fwrite(&REPLAY_VERSION, sizeof(REPLAY_VERSION), 1, m_file) != 1 ||
+     fwrite(&header, sizeof(header), 1, m_file) != 1) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool ReplayWriter::writeFrame(const ReplayFrame& frame) {
+  Assert(m_file != nullptr);
+  return fwrite(&frame, sizeof(frame), 1, m_file) == 1;
+}
+
+bool ReplayWriter::close() {
+  if(m_file == nullptr) {
+    return true;
+  }
+
+  bool closed = fclose(m_file) == 0;
+  m_file = nullptr;
+
+  return closed;
+}
+
+bool ReplayWriter::isOpen() const {
+  return m_file != nullptr;
+}
+
+ReplayReader::ReplayReader(): m_file(nullptr), m_header() { }
+
+ReplayReader::~ReplayReader() {
+  close();
+}
+
+bool ReplayReader::open(const char* path) {
+  Assert(m_file == nullptr);
+
+  m_file = fopen(path, "rb");
+  if(m_file == nullptr) {
+    return false;
+  }
+
+  char magic[sizeof(REPLAY_MAGIC)];
+  uint32_t version;
+  if(fread(magic, sizeof(magic), 1, m_file) != 1 ||
+     memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 ||
+     fread(&version, sizeof(version), 1, m_file) != 1 || version != REPLAY_VERSION ||
+     fread(&m_header, sizeof(m_header), 1, m_file) != 1) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool ReplayReader::readFrame(ReplayFrame& frame) {
+  Assert(m_file != nullptr);
+  return fread(&frame, sizeof(frame), 1, m_file) == 1;
+}
+
+void ReplayReader::close() {
+  if(m_file != nullptr) {
+    fclose(m_file);
+    m_file = nullptr;
+  }
+}
+
+bool ReplayReader::isOpen() const {
+  return m_file != nullptr;
+}
+
+const ReplayHeader& ReplayReader::getHeader() const {
+  return m_header;
+}
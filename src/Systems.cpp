@@ -2,76 +2,106 @@
 #include "PlayerStates.h"
 #include "ZombieStates.h"
 #include "Utils.h"
+#include "Random.h"
 
+#include <algorithm>
 #include <fstream>
 
 
 static void generateEffect(EffectType type, vec2 position,
                            real scale, real angle, real lifetime,
                            bool fadeout) {
-  Message msg;
-  msg.type = int(MessageType::SPAWN_EFFECT);
-  msg.effect_info.type = type;
-  msg.effect_info.x = position.x;
-  msg.effect_info.y = position.y;
-  msg.effect_info.scale = scale;
-  msg.effect_info.angle = angle;
-  msg.effect_info.lifetime = lifetime;
-  msg.effect_info.fadeOut = fadeout;
-
-  notify(msg);
+  SpawnEffectMessage msg;
+  msg.type = type;
+  msg.position = position;
+  msg.scale = scale;
+  msg.angle = angle;
+  msg.lifetime = lifetime;
+  msg.fadeOut = fadeout;
+
+  post(msg);
 
 }
 
 
-static Entity getPlayer(Registry* registry, Bitfield components) {
+static Entity getPlayer(Query* players) {
 
-  auto players = registry->findEntities(components);
-  Assert(!players.empty());
-  return players.front();
+  Assert(!players->isEmpty());
+  return *players->begin();
 
 }
 
+// NOTE(mizofix): calls function(entityA, entityB) for the collisions of the last
+// tick, where one entity has componentsA and the other one has componentsB. The
+// entities are passed in this order, pairs with dead entities are skipped
+template <typename Function>
+static void forEachCollision(const Registry* registry,
+                             const Bitset& componentsA, const Bitset& componentsB,
+                             Function function) {
+  for(const CollisionMessage& collision: getMessages<CollisionMessage>()) {
+    if(registry->hasComponents(collision.entityA, componentsA) &&
+       registry->hasComponents(collision.entityB, componentsB)) {
+      function(collision.entityA, collision.entityB);
+    }
+    else if(registry->hasComponents(collision.entityB, componentsA) &&
+            registry->hasComponents(collision.entityA, componentsB)) {
+      function(collision.entityB, collision.entityA);
+    }
+  }
+}
+
 static bool isOutOfMap(const vec2& position, real mapWidth, real mapHeight) {
   return (position.x > mapWidth * 0.5f  || position.x < -mapWidth * 0.5f ||
           position.y > mapHeight * 0.5f || position.y < -mapHeight * 0.5f);
 }
 
+bool TrailSystem::init(ECSContext& context) {
+  m_access.read(ComponentID::Transformation)
+          .read(ComponentID::Physics)
+          .write(ComponentID::Trail);
+
+  m_trails = context.registry->createQuery(buildBitfield(ComponentID::Trail));
+
+  return true;
+}
+
 void TrailSystem::update(ECSContext& context, real deltaTime) {
 
   Registry* registry = context.registry;
+  CommandBuffer* commands = context.commands;
 
-  Bitfield desiredComponents = buildBitfield(ComponentID::Trail);
-  auto trails = registry->findEntities(desiredComponents);
-
-  std::list<Entity> proceededTrails;
+  m_randomValues.resize(m_trails->getSize() * 2);
+  getRandom(RandomStream::Trails).fillReals(m_randomValues.data(), m_randomValues.size(), 0.0f, 1.0f);
 
-  for(auto trail: trails) {
-    Trail* trailComponent = registry->getComponent<Trail>(trail, ComponentID::Trail);
+  std::size_t trailIndex = 0;
+  m_trails->each<Trail>([&](Entity trail, Trail& trailComponent) {
+    const real* randomValues = &m_randomValues[trailIndex * 2];
+    trailIndex++;
 
-    bool targetExists = registry->isEntityExists(trailComponent->target);
+    bool targetExists = registry->isEntityExists(trailComponent.target);
     if(targetExists) {
-      Transformation* targetTransf = registry->getComponent<Transformation>(trailComponent->target, ComponentID::Transformation);
+      Transformation* targetTransf = registry->getComponent<Transformation>(trailComponent.target);
 
-      Physics* targetPhysics = registry->getComponent<Physics>(trailComponent->target, ComponentID::Physics);
+      Physics* targetPhysics = registry->getComponent<Physics>(trailComponent.target);
 
       Assert(targetTransf != nullptr);
       Assert(targetPhysics != nullptr);
 
 
-      trailComponent->particles.push_back(generateParticle(targetPhysics->velocity,
-                                                           targetTransf->position,
-                                                           trailComponent->maxRandomAngle,
-                                                           trailComponent->maxSpeed));
+      trailComponent.particles.push_back(generateParticle(targetPhysics->velocity,
+                                                          targetTransf->position,
+                                                          trailComponent.maxRandomAngle,
+                                                          trailComponent.maxSpeed,
+                                                          randomValues));
 
     }
 
-    for(auto particleIt = trailComponent->particles.begin();
-        particleIt != trailComponent->particles.end();) {
+    for(auto particleIt = trailComponent.particles.begin();
+        particleIt != trailComponent.particles.end();) {
 
       particleIt->elapsedTime += deltaTime;
-      if(particleIt->elapsedTime >= trailComponent->lifetime) {
-        particleIt = trailComponent->particles.erase(particleIt);
+      if(particleIt->elapsedTime >= trailComponent.lifetime) {
+        particleIt = trailComponent.particles.erase(particleIt);
       } else {
         particleIt->position += particleIt->velocity * deltaTime;
         particleIt++;
@@ -79,46 +109,38 @@ void TrailSystem::update(ECSContext& context, real deltaTime) {
 
     }
 
-    if(!targetExists && trailComponent->particles.empty()) {
-      proceededTrails.push_back(trail);
+    if(!targetExists && trailComponent.particles.empty()) {
+      commands->destroyEntity(trail);
     }
 
-  }
-
-  for(auto trail: proceededTrails) {
-    registry->destroyEntity(trail);
-  }
+  });
 
 }
 
 void TrailSystem::draw(ECSContext& context) {
-  Registry* registry = context.registry;
 
-  Bitfield desiredComponents = buildBitfield(ComponentID::Trail);
-  auto trails = registry->findEntities(desiredComponents);
+  m_trails->each<Trail>([](Entity trail, Trail& trailComponent) {
 
-  for(auto trail: trails) {
-    Trail* trailComponent = registry->getComponent<Trail>(trail, ComponentID::Trail);
-
-    for(auto& particle: trailComponent->particles) {
-      int alpha = int((1.0f - particle.elapsedTime / trailComponent->lifetime) * 255.0f);
+    for(auto& particle: trailComponent.particles) {
+      int alpha = int((1.0f - particle.elapsedTime / trailComponent.lifetime) * 255.0f);
       drawRect(round(particle.position.x),round(particle.position.y),
-               trailComponent->size, trailComponent->size,
+               trailComponent.size, trailComponent.size,
                128, 128, 128, alpha, 0.5f, 0.5f);
     }
-  }
+  });
 }
 
 TrailParticle TrailSystem::generateParticle(const vec2& targetVelocity, const vec2& position,
-                                            real maxAngle, real maxSpeed) {
+                                            real maxAngle, real maxSpeed,
+                                            const real* randomValues) {
   TrailParticle newParticle;
   newParticle.position = position;
   newParticle.elapsedTime = 0.0f;
 
   real targetDirectionAngle = vecToDeg(targetVelocity);
 
-  real particleDirectionAgle = targetDirectionAngle + randomReal(0.0f, maxAngle);
-  real particleSpeed = randomReal(0.0f, maxSpeed);
+  real particleDirectionAgle = targetDirectionAngle + randomValues[0] * maxAngle;
+  real particleSpeed = randomValues[1] * maxSpeed;
 
   newParticle.velocity = degToVec(particleDirectionAgle) * particleSpeed;
 
@@ -126,29 +148,29 @@ TrailParticle TrailSystem::generateParticle(const vec2& targetVelocity, const ve
 }
 
 bool PlayerSystem::init(ECSContext& context) {
-  registerMethod<PlayerSystem>(int(MessageType::ON_MOUSE_WHEEL),
-                               &PlayerSystem::onMouseWheel,
-                               this);
+  // NOTE(mizofix): player states create bullets right through the registry
+  m_access.setExclusive();
 
-  registerMethod<PlayerSystem>(int(MessageType::ZOMBIE_ATTACK),
-                               &PlayerSystem::onZombieAttack,
-                               this);
+  m_mouseWheelSubscription = subscribe<&PlayerSystem::onMouseWheel>(this);
 
-  registerMethod<PlayerSystem>(int(MessageType::ON_COLLISION),
-                               &PlayerSystem::onCollision,
-                               this);
+  Bitset playerComponents = buildBitfield(ComponentID::Model,
+                                            ComponentID::Transformation,
+                                            ComponentID::Attributes,
+                                            ComponentID::Player,
+                                            ComponentID::Physics);
 
-  Entity player = context.registry->createEntity();
+  Entity player = context.registry->createEntity(playerComponents);
 
-  Model* model = new Model("knife_idle");
+  Model* model = context.registry->getComponent<Model>(player);
+  model->sprite = createSprite("knife_idle");
   setFrozenAnimation(model->sprite, true);
   resetAnimation(model->sprite);
 
   // TODO(mizofix): spawn at random position
-  Transformation* transf = new Transformation();
+  Transformation* transf = context.registry->getComponent<Transformation>(player);
   transf->position = vec2(320, 240);
 
-  Attributes* attributes = new Attributes();
+  Attributes* attributes = context.registry->getComponent<Attributes>(player);
   attributes->maxHealth = context.data.maxPlayerHealth;
   attributes->health = attributes->maxHealth;
   attributes->maxStamina = context.data.maxPlayerStamina;
@@ -157,30 +179,22 @@ bool PlayerSystem::init(ECSContext& context) {
   attributes->regenSpeed = context.data.regenSpeed;
 
 
-  Physics* physics = new Physics();
+  Physics* physics = context.registry->getComponent<Physics>(player);
   physics->mass = 100.0f;
   physics->size = 32.0f;
   physics->maxSpeed = context.data.maxPlayerSpeed;
+  physics->collisionLayer = CollisionLayers::PLAYER;
+  physics->collisionMask = CollisionLayers::ZOMBIE | CollisionLayers::PICKUP;
 
-  Player* playerComponent = new Player();
+  Player* playerComponent = context.registry->getComponent<Player>(player);
   initWeapons(playerComponent);
+  playerComponent->stateController = new StateController();
 
   // TODO(mizofix): change damping based on current tile
   physics->damping = 1.0f;
 
-  context.registry->addComponent(player, model);
-  context.registry->addComponent(player, transf);
-  context.registry->addComponent(player, attributes);
-  context.registry->addComponent(player, playerComponent);
-  context.registry->addComponent(player, physics);
-
-  m_playerBitfield = buildBitfield(ComponentID::Model,
-                                   ComponentID::Transformation,
-                                   ComponentID::Attributes,
-                                   ComponentID::Player,
-                                   ComponentID::Physics);
+  m_players = context.registry->createQuery(playerComponents);
 
-  playerComponent->stateController = new StateController();
   playerComponent->stateController->setState<PlayerIdle>(context, player);
 
   return true;
@@ -237,12 +251,12 @@ WeaponData PlayerSystem::parseWeapon(nlohmann::json& parser) {
 
 void PlayerSystem::update(ECSContext& context, real deltaTime) {
   Registry* registry = context.registry;
-  Entity player = getPlayer(context.registry, m_playerBitfield);
+  Entity player = getPlayer(m_players);
 
-  Physics* physics = registry->getComponent<Physics>(player, ComponentID::Physics);
-  Player* playerComponent = registry->getComponent<Player>(player, ComponentID::Player);
-  Transformation* transf = registry->getComponent<Transformation>(player, ComponentID::Transformation);
-  Attributes* attributes = registry->getComponent<Attributes>(player, ComponentID::Attributes);
+  Physics* physics = registry->getComponent<Physics>(player);
+  Player* playerComponent = registry->getComponent<Player>(player);
+  Transformation* transf = registry->getComponent<Transformation>(player);
+  Attributes* attributes = registry->getComponent<Attributes>(player);
 
   if(attributes->health <= 0.0f) {
     notifyPlayerDead();
@@ -310,13 +324,11 @@ void PlayerSystem::update(ECSContext& context, real deltaTime) {
     physics->idling = true;
   }
 
-  setCameraPosition(round(transf->position.x), round(transf->position.y));
-
   playerComponent->stateController->update(context, player, deltaTime);
 
   bool playerAttacked = false;
-  for(auto msg: m_unprocessedZombieAttacks) {
-    vec2 attackPosition = vec2(msg.attack_info.x, msg.attack_info.y);
+  for(const ZombieAttackMessage& msg: getMessages<ZombieAttackMessage>()) {
+    vec2 attackPosition = msg.position;
     vec2 vecToPlayer = transf->position - attackPosition;
     real distanceToPlayer = vecToPlayer.length();
     if(distanceToPlayer > 0.01) {
@@ -325,8 +337,8 @@ void PlayerSystem::update(ECSContext& context, real deltaTime) {
     }
 
     if(distanceToPlayer < physics->size * 3.0f &&
-       vecToPlayer.dot(degToVec(msg.attack_info.angle)) > cos(degToRad(45.0f))) {
-      attributes->health -= msg.attack_info.damage;
+       vecToPlayer.dot(degToVec(msg.angle)) > cos(degToRad(45.0f))) {
+      attributes->health -= msg.damage;
 
       generateEffect(EffectType::BLOOD, transf->position, 1.0f, transf->angle, 3.0f, true);
       generateEffect(EffectType::BLOODPRINT, transf->position, 1.0f, transf->angle, 7.0f, true);
@@ -336,9 +348,7 @@ void PlayerSystem::update(ECSContext& context, real deltaTime) {
 
   }
 
-  m_unprocessedZombieAttacks.clear();
-
-  processPlayerCollisions(registry);
+  processPlayerCollisions(registry, context.commands);
 
   if(!playerAttacked) {
     attributes->health = std::min(attributes->health + attributes->regenSpeed * deltaTime,
@@ -355,48 +365,25 @@ void PlayerSystem::update(ECSContext& context, real deltaTime) {
 }
 
 void PlayerSystem::notifyPlayerDead() {
-  Message msg;
-  msg.type = int(MessageType::PLAYER_DEAD);
-  notify(msg);
+  notify(PlayerDeadMessage());
 }
 
 
-void PlayerSystem::processPlayerCollisions(Registry* registry) {
-  for(auto collision: m_unprocessedCollisions) {
-    Entity player = Constants::INVALID_ENTITY;
-    Entity box = Constants::INVALID_ENTITY;
-
-    if(registry->hasComponent(collision.collision_info.entityA, ComponentID::Player)) {
-      player = collision.collision_info.entityA;
-    }
-    else if(registry->hasComponent(collision.collision_info.entityB, ComponentID::Player)) {
-      player = collision.collision_info.entityB;
-    }
+void PlayerSystem::processPlayerCollisions(Registry* registry, CommandBuffer* commands) {
+  forEachCollision(registry, buildBitfield(ComponentID::Player), buildBitfield(ComponentID::Weapon),
+                   [&](Entity player, Entity box) {
+    Player* playerComponent = registry->getComponent<Player>(player);
+    WeaponBox* weaponComponent = registry->getComponent<WeaponBox>(box);
 
-    if(registry->hasComponent(collision.collision_info.entityA, ComponentID::Weapon)) {
-      box = collision.collision_info.entityA;
-    }
-    else if(registry->hasComponent(collision.collision_info.entityB, ComponentID::Weapon)) {
-      box = collision.collision_info.entityB;
-    }
-
-    if(player != Constants::INVALID_ENTITY && box != Constants::INVALID_ENTITY) {
-      Player* playerComponent = registry->getComponent<Player>(player, ComponentID::Player);
-      WeaponBox* weaponComponent = registry->getComponent<WeaponBox>(box, ComponentID::Weapon);
-
-      for(auto& weapon: playerComponent->weapons) {
-        if(weapon.type == weaponComponent->type) {
-          weapon.availableClips += weaponComponent->clips;
-          break;
-        }
+    for(auto& weapon: playerComponent->weapons) {
+      if(weapon.type == weaponComponent->type) {
+        weapon.availableClips += weaponComponent->clips;
+        break;
       }
-
-      registry->destroyEntity(box);
-
     }
-  }
 
-  m_unprocessedCollisions.clear();
+    commands->destroyEntity(box);
+  });
 }
 
 void PlayerSystem::checkCurrentWeapon(Player* player) {
@@ -408,16 +395,17 @@ void PlayerSystem::checkCurrentWeapon(Player* player) {
   }
 }
 
-void PlayerSystem::onCollision(Message message) {
-  m_unprocessedCollisions.push_back(message);
-}
+void PlayerSystem::draw(ECSContext& context) {
+  Entity player = getPlayer(m_players);
+  Transformation* transf = context.registry->getComponent<Transformation>(player);
 
-void PlayerSystem::onZombieAttack(Message message) {
-  m_unprocessedZombieAttacks.push_back(message);
+  // NOTE(mizofix): the camera follows the drawn player, not the simulated one
+  vec2 position = transf->getInterpolatedPosition(context.interpolationFactor);
+  setCameraPosition(round(position.x), round(position.y));
 }
 
-void PlayerSystem::onMouseWheel(Message message) {
-  m_lastFrameMouseWheel = message.wheel.y;
+void PlayerSystem::onMouseWheel(const MouseWheelMessage& message) {
+  m_lastFrameMouseWheel = message.y;
 }
 
 real PlayerSystem::getPlayerViewDirection() {
@@ -434,10 +422,24 @@ real PlayerSystem::getPlayerViewDirection() {
 }
 
 bool ZombieSystem::init(ECSContext& context) {
-  m_zombieComponents = buildBitfield(ComponentID::Model,
-                                     ComponentID::Transformation,
-                                     ComponentID::Physics,
-                                     ComponentID::Zombie);
+  m_access.read(ComponentID::Player)
+          .write(ComponentID::Transformation)
+          .write(ComponentID::Physics)
+          .write(ComponentID::Attributes)
+          .write(ComponentID::Zombie)
+          .write(ComponentID::Model)
+          .use(SystemResource::WorldData);
+
+  m_zombies = context.registry->createQuery(buildBitfield(ComponentID::Model,
+                                                         ComponentID::Transformation,
+                                                         ComponentID::Physics,
+                                                         ComponentID::Attributes,
+                                                         ComponentID::Zombie));
+
+  m_players = context.registry->createQuery(buildBitfield(ComponentID::Transformation,
+                                                         ComponentID::Physics,
+                                                         ComponentID::Player,
+                                                         ComponentID::Attributes));
 
   return true;
 }
@@ -445,116 +447,108 @@ bool ZombieSystem::init(ECSContext& context) {
 void ZombieSystem::update(ECSContext& context, real deltaTime) {
   Registry* registry = context.registry;
 
-  Bitfield playerComponents = buildBitfield(ComponentID::Transformation,
-                                            ComponentID::Physics,
-                                            ComponentID::Player,
-                                            ComponentID::Attributes);
-
-
-  Entity player = getPlayer(registry, playerComponents);
-  Transformation* playerTransform = registry->getComponent<Transformation>(player,
-                                                                           ComponentID::Transformation);
-  std::list<Entity> proceededZombies;
+  Entity player = getPlayer(m_players);
+  Transformation* playerTransform = registry->getComponent<Transformation>(player);
+  CommandBuffer* commands = context.commands;
+  Random& random = getRandom(RandomStream::Zombies);
 
   // TODO(mizofix): calculate fov based on player alpha
-  auto zombies = registry->findEntities(m_zombieComponents);
-  for(auto zombie: zombies) {
-    Transformation* zombieTransform = registry->getComponent<Transformation>(zombie,
-                                                                             ComponentID::Transformation);
-    Zombie* zombieComponent = registry->getComponent<Zombie>(zombie, ComponentID::Zombie);
-    Physics* zombiePhysics = registry->getComponent<Physics>(zombie, ComponentID::Physics);
-    Attributes* zombieAttributes = registry->getComponent<Attributes>(zombie, ComponentID::Attributes);
-
-    if(zombieAttributes->health <= 0.0f) {
+  m_zombies->each<Transformation, Zombie, Physics, Attributes>([&](Entity zombie,
+                                                                  Transformation& zombieTransform,
+                                                                  Zombie& zombieComponent,
+                                                                  Physics& zombiePhysics,
+                                                                  Attributes& zombieAttributes) {
+
+    if(zombieAttributes.health <= 0.0f) {
       real remainingTime = context.data.roundData.roundTime - context.data.roundData.elapsedTime;
-      proceededZombies.push_back(zombie);
+      commands->destroyEntity(zombie);
       generateEffect(EffectType::ZOMBIE_DEATH,
-                     zombieTransform->position,
-                     zombieTransform->scale, zombieTransform->angle, remainingTime,
+                     zombieTransform.position,
+                     zombieTransform.scale, zombieTransform.angle, remainingTime,
                      true);
 
       context.data.zombieCounter++;
-      continue;
+      return;
     }
 
-    zombieComponent->stateController->update(context, zombie, deltaTime);
+    zombieComponent.stateController->update(context, zombie, deltaTime);
 
-    vec2 vecToPlayer = playerTransform->position - zombieTransform->position;
+    vec2 vecToPlayer = playerTransform->position - zombieTransform.position;
     real distanceToPlayer = vecToPlayer.length();
     if(distanceToPlayer > 0.01) {
       vecToPlayer.x /= distanceToPlayer;
       vecToPlayer.y /= distanceToPlayer;
     }
 
-    if(zombieComponent->attacking) {
-      zombieTransform->angle = vecToDeg(vecToPlayer);
-      continue;
+    if(zombieComponent.attacking) {
+      zombieTransform.angle = vecToDeg(vecToPlayer);
+      return;
     }
 
 
-    if(zombieComponent->sawPlayerRecently && distanceToPlayer  > zombieComponent->followingDistance) {
-      zombieComponent->sawPlayerRecently = false;
-      zombiePhysics->velocity = vec2();
-      zombieComponent->stateController->setState<ZombieIdle>(context, zombie);
+    if(zombieComponent.sawPlayerRecently && distanceToPlayer  > zombieComponent.followingDistance) {
+      zombieComponent.sawPlayerRecently = false;
+      zombiePhysics.velocity = vec2();
+      zombieComponent.stateController->setState<ZombieIdle>(context, zombie);
     }
-    else if(zombieComponent->sawPlayerRecently) {
+    else if(zombieComponent.sawPlayerRecently) {
       // NOTE(mizofix): if zombie close enough to attack a player
-      if(distanceToPlayer < zombieComponent->attackDistance) {
-        zombieComponent->stateController->setState<ZombieAttack>(context, zombie);
-        zombiePhysics->velocity = vec2();
+      if(distanceToPlayer < zombieComponent.attackDistance) {
+        zombieComponent.stateController->setState<ZombieAttack>(context, zombie);
+        zombiePhysics.velocity = vec2();
       }
       else {
         // TODO(mizofix): predict player path
-        zombiePhysics->velocity = vecToPlayer * zombiePhysics->maxSpeed;
-        zombieTransform->angle = vecToDeg(vecToPlayer);
+        zombiePhysics.velocity = vecToPlayer * zombiePhysics.maxSpeed;
+        zombieTransform.angle = vecToDeg(vecToPlayer);
 
       }
 
     } else {
 
-      real relativeDirection = degToVec(zombieTransform->angle).dot(vecToPlayer);
+      real relativeDirection = degToVec(zombieTransform.angle).dot(vecToPlayer);
 
       // NOTE(mizofix): if zombie hears or see a player
-      if(distanceToPlayer < zombieComponent->hearingDistance ||
-         (relativeDirection >= zombieComponent->fov &&
-          distanceToPlayer < zombieComponent->followingDistance)) {
+      if(distanceToPlayer < zombieComponent.hearingDistance ||
+         (relativeDirection >= zombieComponent.fov &&
+          distanceToPlayer < zombieComponent.followingDistance)) {
 
-        zombieComponent->sawPlayerRecently = true;
+        zombieComponent.sawPlayerRecently = true;
 
       }
 
       else {
 
-        vec2 vecToTarget = zombieComponent->wanderingTarget - zombieTransform->position;
+        vec2 vecToTarget = zombieComponent.wanderingTarget - zombieTransform.position;
         real distanceToTarget = vecToTarget.length();
         vecToTarget.x /= distanceToTarget;
         vecToTarget.y /= distanceToTarget;
 
-        if(zombieComponent->wanderingTarget.x < -context.data.mapWidth * 0.5f) {
-          zombieComponent->wanderingTarget.x = -context.data.mapWidth * 0.5f + randomReal(0.0f, 200.0f);
+        if(zombieComponent.wanderingTarget.x < -context.data.mapWidth * 0.5f) {
+          zombieComponent.wanderingTarget.x = -context.data.mapWidth * 0.5f + random.nextReal(0.0f, 200.0f);
         }
-        else if(zombieComponent->wanderingTarget.x > context.data.mapWidth * 0.5f) {
-          zombieComponent->wanderingTarget.x = context.data.mapWidth * 0.5f - randomReal(0.0f, 200.0f);
+        else if(zombieComponent.wanderingTarget.x > context.data.mapWidth * 0.5f) {
+          zombieComponent.wanderingTarget.x = context.data.mapWidth * 0.5f - random.nextReal(0.0f, 200.0f);
         }
 
-        if(zombieComponent->wanderingTarget.y < -context.data.mapHeight * 0.5f) {
-          zombieComponent->wanderingTarget.y = -context.data.mapHeight * 0.5f + randomReal(0.0f, 200.0f);
+        if(zombieComponent.wanderingTarget.y < -context.data.mapHeight * 0.5f) {
+          zombieComponent.wanderingTarget.y = -context.data.mapHeight * 0.5f + random.nextReal(0.0f, 200.0f);
         }
-        else if(zombieComponent->wanderingTarget.y > context.data.mapHeight * 0.5f) {
-          zombieComponent->wanderingTarget.y = context.data.mapHeight * 0.5f - randomReal(0.0f,200.0f);
+        else if(zombieComponent.wanderingTarget.y > context.data.mapHeight * 0.5f) {
+          zombieComponent.wanderingTarget.y = context.data.mapHeight * 0.5f - random.nextReal(0.0f,200.0f);
         }
 
         if(distanceToTarget > 50.0f) {
-          zombiePhysics->velocity = vecToTarget * zombiePhysics->maxSpeed;
-          zombieTransform->angle = vecToDeg(vecToTarget);
+          zombiePhysics.velocity = vecToTarget * zombiePhysics.maxSpeed;
+          zombieTransform.angle = vecToDeg(vecToTarget);
         } else {
-          zombieComponent->wanderingElapsedTime += deltaTime;
-          if(zombieComponent->wanderingElapsedTime > 2.5f) {
-              real rndX = randomReal(-200.0f, 200.0f);
-              real rndY = randomReal(-200.0f, 200.0f);
-              zombieComponent->wanderingTarget = zombieTransform->position + vec2(rndX, rndY);
+          zombieComponent.wanderingElapsedTime += deltaTime;
+          if(zombieComponent.wanderingElapsedTime > 2.5f) {
+              real rndX = random.nextReal(-200.0f, 200.0f);
+              real rndY = random.nextReal(-200.0f, 200.0f);
+              zombieComponent.wanderingTarget = zombieTransform.position + vec2(rndX, rndY);
 
-              zombieComponent->wanderingElapsedTime = 0.0f;
+              zombieComponent.wanderingElapsedTime = 0.0f;
           }
         }
 
@@ -562,20 +556,28 @@ void ZombieSystem::update(ECSContext& context, real deltaTime) {
 
     }
 
-  }
-
-  for(auto zombie: proceededZombies) {
-    registry->destroyEntity(zombie);
-  }
-
+  });
 
 }
 
 bool LevelSystem::init(ECSContext& context) {
+  // NOTE(mizofix): spawns zombies and boxes right through the registry
+  m_access.setExclusive();
+
   m_elapsedTimeFromLastZombieGeneration = 0.0f;
   m_elapsedTimeFromLastBoxGeneration = 0.0f;
 
-  int initialBoxesCount = rand() % 3;
+  Registry* registry = context.registry;
+  m_players = registry->createQuery(buildBitfield(ComponentID::Transformation,
+                                                  ComponentID::Player));
+
+  m_zombies = registry->createQuery(buildBitfield(ComponentID::Zombie,
+                                                  ComponentID::Attributes,
+                                                  ComponentID::Transformation));
+
+  m_weapons = registry->createQuery(buildBitfield(ComponentID::Weapon));
+
+  int initialBoxesCount = getRandom(RandomStream::Level).nextInt(3);
   for(int i = 0; i < initialBoxesCount + 1; ++i) {
     generateWeaponBox(context, vec2());
   }
@@ -585,15 +587,9 @@ bool LevelSystem::init(ECSContext& context) {
 
 void LevelSystem::update(ECSContext& context, real deltaTime) {
 
-  Registry* registry = context.registry;
-
-  Bitfield playerBitfield = buildBitfield(ComponentID::Transformation,
-                                          ComponentID::Player);
-
-  Entity player = getPlayer(registry, playerBitfield);
+  Entity player = getPlayer(m_players);
 
-  Transformation* playerTransf = context.registry->getComponent<Transformation>(player,
-                                                                                ComponentID::Transformation);
+  Transformation* playerTransf = context.registry->getComponent<Transformation>(player);
 
 
   m_elapsedTimeFromLastBoxGeneration += deltaTime;
@@ -612,12 +608,6 @@ void LevelSystem::update(ECSContext& context, real deltaTime) {
   }
   else {
 
-    Bitfield zombieComponents = buildBitfield(ComponentID::Zombie,
-                                              ComponentID::Attributes,
-                                              ComponentID::Transformation);
-
-    auto zombies = registry->findEntities(zombieComponents);
-
     if(context.data.roundData.elapsedTime > context.data.roundData.roundTime) {
 
       context.data.roundData.intermissionActivated = true;
@@ -625,19 +615,16 @@ void LevelSystem::update(ECSContext& context, real deltaTime) {
       context.data.roundData.roundTime = 20.0f;
       context.data.roundData.currentRoundNumber++;
 
-      for(auto zombie: zombies) {
+      m_zombies->each<Attributes>([](Entity zombie, Attributes& zombieAttributes) {
 
-        Attributes* zombieAttributes = registry->getComponent<Attributes>(zombie,
-                                                                          ComponentID::Attributes);
+        zombieAttributes.health = -100.0f;
 
-        zombieAttributes->health = -100.0f;
-
-      }
+      });
 
     } else {
 
       uint32_t zombiesMaxCount = std::min(currentRound * 10 + 25, context.data.numEnemies);
-      if(zombies.size() < zombiesMaxCount) {
+      if(m_zombies->getSize() < zombiesMaxCount) {
         real zombieSpawnTime = std::max(0.2f - real(currentRound) * 0.05f, 0.01f);
         if(m_elapsedTimeFromLastZombieGeneration > zombieSpawnTime) {
           generateZombie(context, playerTransf->position);
@@ -645,15 +632,14 @@ void LevelSystem::update(ECSContext& context, real deltaTime) {
         }
       }
 
-      for(auto zombie: zombies) {
-        Transformation* zombieTransf = registry->getComponent<Transformation>(zombie,
-                                                                              ComponentID::Transformation);
+      CommandBuffer* commands = context.commands;
+      m_zombies->each<Transformation>([&](Entity zombie, Transformation& zombieTransf) {
 
-        if(playerTransf->position.distance(zombieTransf->position) > 1500.0f) {
-          registry->destroyEntity(zombie);
+        if(playerTransf->position.distance(zombieTransf.position) > 1500.0f) {
+          commands->destroyEntity(zombie);
         }
 
-      }
+      });
 
     }
 
@@ -661,9 +647,7 @@ void LevelSystem::update(ECSContext& context, real deltaTime) {
 
 
 
-  Bitfield weaponsComponents = buildBitfield(ComponentID::Weapon);
-  auto weapons = registry->findEntities(weaponsComponents);
-  if(context.data.roundData.intermissionActivated && weapons.size() < 3 + currentRound &&
+  if(context.data.roundData.intermissionActivated && m_weapons->getSize() < 3 + currentRound &&
      m_elapsedTimeFromLastBoxGeneration > 30.0f) {
     generateWeaponBox(context, playerTransf->position);
   }
@@ -673,28 +657,36 @@ void LevelSystem::update(ECSContext& context, real deltaTime) {
 void LevelSystem::generateZombie(ECSContext& context, const vec2& playerPos) {
 
   Registry* registry = context.registry;
-  Entity zombie = registry->createEntity();
+  Entity zombie = registry->createEntity(buildBitfield(ComponentID::Model,
+                                                      ComponentID::Transformation,
+                                                      ComponentID::Physics,
+                                                      ComponentID::Zombie,
+                                                      ComponentID::Attributes));
 
   real currentRound = context.data.roundData.currentRoundNumber;
+  Random& random = getRandom(RandomStream::Level);
 
-  Model* model = new Model();
+  Model* model = registry->getComponent<Model>(zombie);
   model->sprite = createSprite("zombie_idle");
-  model->alpha = int(randomReal(200.0f, 255.0f));
+  model->alpha = int(random.nextReal(200.0f, 255.0f));
 
 
-  Transformation* transf = new Transformation();
+  Transformation* transf = registry->getComponent<Transformation>(zombie);
 
   real threshold = std::max(context.data.windowHeight, context.data.windowWidth) * 0.6f;
   transf->position = generateRandomPosition(playerPos, threshold, 1.4f * threshold,
                                             context.data.mapWidth, context.data.mapHeight);
-  transf->angle = randomReal(0.0f, 360.0f);
-  transf->scale = randomReal(0.8f, 1.2f);
+  transf->angle = random.nextReal(0.0f, 360.0f);
+  transf->scale = random.nextReal(0.8f, 1.2f);
 
-  Physics* physics = new Physics();
+  Physics* physics = registry->getComponent<Physics>(zombie);
   physics->size = 15.0f * transf->scale;
   physics->maxSpeed = 50.0f + 10.0f * currentRound;
+  physics->collisionLayer = CollisionLayers::ZOMBIE;
+  physics->collisionMask = CollisionLayers::PLAYER | CollisionLayers::ZOMBIE |
+                           CollisionLayers::BULLET | CollisionLayers::MELEE;
 
-  Zombie* zombieComponent = new Zombie();
+  Zombie* zombieComponent = registry->getComponent<Zombie>(zombie);
   zombieComponent->wanderingTarget = transf->position;
   zombieComponent->fov = cos(degToRad(std::min(45.0f + 5.0f * currentRound, 160.0f)));
   zombieComponent->hearingDistance = 50.0f + 35.0f * currentRound;
@@ -703,17 +695,11 @@ void LevelSystem::generateZombie(ECSContext& context, const vec2& playerPos) {
   zombieComponent->sawPlayerRecently = false;
   zombieComponent->stateController = new StateController();
 
-  Attributes* attributes = new Attributes();
+  Attributes* attributes = registry->getComponent<Attributes>(zombie);
   attributes->maxHealth = 200.0f + 100.0f * currentRound;
-  attributes->health = attributes->maxHealth * randomReal(0.25f, 1.0f);
+  attributes->health = attributes->maxHealth * random.nextReal(0.25f, 1.0f);
   attributes->damage = 5.0f + 2.5f * currentRound;
 
-  registry->addComponent(zombie, model);
-  registry->addComponent(zombie, transf);
-  registry->addComponent(zombie, physics);
-  registry->addComponent(zombie, zombieComponent);
-  registry->addComponent(zombie, attributes);
-
   zombieComponent->stateController->setState<ZombieIdle>(context, zombie);
 
 }
@@ -722,8 +708,12 @@ void LevelSystem::generateWeaponBox(ECSContext& context, const vec2& playerPos)
 
   Registry* registry = context.registry;
 
-  Entity weaponBox = registry->createEntity();
-  WeaponType weaponType = WeaponType(int(WeaponType::PISTOL) + rand() % 3);
+  Entity weaponBox = registry->createEntity(buildBitfield(ComponentID::Model,
+                                                         ComponentID::Transformation,
+                                                         ComponentID::Physics,
+                                                         ComponentID::Weapon));
+  Random& random = getRandom(RandomStream::Level);
+  WeaponType weaponType = WeaponType(int(WeaponType::PISTOL) + random.nextInt(3));
   const char* boxSpriteName = "";
   switch(weaponType) {
   case WeaponType::PISTOL: boxSpriteName = "box_pistol"; break;
@@ -731,166 +721,202 @@ void LevelSystem::generateWeaponBox(ECSContext& context, const vec2& playerPos)
   case WeaponType::SHOTGUN: boxSpriteName = "box_shotgun"; break;
   default: break;
   }
-  Model* model = new Model();
+  Model* model = registry->getComponent<Model>(weaponBox);
   model->sprite = createSprite(boxSpriteName);
-  Transformation* transf = new Transformation();
-  transf->angle = randomReal(0.0f, 360.0f);
+  Transformation* transf = registry->getComponent<Transformation>(weaponBox);
+  transf->angle = random.nextReal(0.0f, 360.0f);
   real threshold = std::max(context.data.windowHeight, context.data.windowWidth) * 0.8f;
   transf->position = generateRandomPosition(playerPos, threshold, 2.0f * threshold,
                                             context.data.mapWidth, context.data.mapHeight);
-  Physics* physics = new Physics();
+  Physics* physics = registry->getComponent<Physics>(weaponBox);
   physics->size = 7.5f;
   physics->mass = 9999.0f;
+  physics->collisionLayer = CollisionLayers::PICKUP;
+  physics->collisionMask = CollisionLayers::PLAYER;
 
-  WeaponBox* boxComponent = new WeaponBox();
+  WeaponBox* boxComponent = registry->getComponent<WeaponBox>(weaponBox);
   boxComponent->type = weaponType;
-  boxComponent->clips = rand() % 3 + 2;
-
-  registry->addComponent(weaponBox, model);
-  registry->addComponent(weaponBox, transf);
-  registry->addComponent(weaponBox, physics);
-  registry->addComponent(weaponBox, boxComponent);
+  boxComponent->clips = random.nextInt(3) + 2;
 
 }
 
 vec2 LevelSystem::generateRandomPosition(const vec2& playerPosition, real threshold, real radius,
                                          real width, real height) {
+  Random& random = getRandom(RandomStream::Level);
   vec2 position = playerPosition;
   while((position - playerPosition).sqLength() < threshold * threshold ||
         isOutOfMap(position, width, height)) {
 
-    position.x = randomReal(-radius, radius) + playerPosition.x;
-    position.y = randomReal(-radius, radius) + playerPosition.y;
+    position.x = random.nextReal(-radius, radius) + playerPosition.x;
+    position.y = random.nextReal(-radius, radius) + playerPosition.y;
   }
 
   return position;
 }
 
-void FootprintGenerationSystem::update(ECSContext& context, real deltaTime) {
+bool FootprintGenerationSystem::init(ECSContext& context) {
+  m_access.read(ComponentID::Transformation)
+          .read(ComponentID::Physics)
+          .write(ComponentID::Attributes);
 
-  Registry* registry = context.registry;
+  m_walkers = context.registry->createQuery(buildBitfield(ComponentID::Transformation,
+                                                         ComponentID::Attributes,
+                                                         ComponentID::Physics));
 
-  Bitfield desiredComponents = buildBitfield(ComponentID::Transformation,
-                                             ComponentID::Attributes,
-                                             ComponentID::Physics);
+  return true;
+}
 
-  auto entities = registry->findEntities(desiredComponents);
-  for(auto entity: entities) {
-    Transformation* transf = context.registry->getComponent<Transformation>(entity,
-                                                                            ComponentID::Transformation);
-    Attributes* attributes = context.registry->getComponent<Attributes>(entity,
-                                                                        ComponentID::Attributes);
+void FootprintGenerationSystem::update(ECSContext& context, real deltaTime) {
 
-    Physics* physics = context.registry->getComponent<Physics>(entity, ComponentID::Physics);
+  m_walkers->each<Transformation, Attributes, Physics>([deltaTime](Entity entity,
+                                                                   Transformation& transf,
+                                                                   Attributes& attributes,
+                                                                   Physics& physics) {
 
-    if(!physics->idling) {
+    if(!physics.idling) {
 
-      attributes->footprintElapsedTime += deltaTime;
+      attributes.footprintElapsedTime += deltaTime;
 
       EffectType type = EffectType::FOOTPRINT;
       real printTime = 0.5f;
-      if((attributes->health / attributes->maxHealth) < 0.5) {
+      if((attributes.health / attributes.maxHealth) < 0.5) {
         type = EffectType::BLOODPRINT;
         printTime = 0.35f;
       }
 
-      if(attributes->footprintElapsedTime > printTime) {
-        generateEffect(type, transf->position, 1.0f, transf->angle, 7.0f, true);
-        attributes->footprintElapsedTime = 0.0f;
+      if(attributes.footprintElapsedTime > printTime) {
+        generateEffect(type, transf.position, 1.0f, transf.angle, 7.0f, true);
+        attributes.footprintElapsedTime = 0.0f;
       }
 
     }
 
-  }
+  });
+
+}
 
+bool ModelRenderingSystem::init(ECSContext& context) {
+  m_access.read(ComponentID::Model)
+          .read(ComponentID::Transformation);
+
+  m_models = context.registry->createQuery(buildBitfield(ComponentID::Model,
+                                                        ComponentID::Transformation));
+
+  return true;
 }
 
 void ModelRenderingSystem::draw(ECSContext& context) {
+  real factor = context.interpolationFactor;
 
-  Registry* registry = context.registry;
+  m_models->each<Model, Transformation>([factor](Entity entity, Model& model, Transformation& transf) {
+    vec2 position = transf.getInterpolatedPosition(factor);
+    drawSprite(model.sprite, round(position.x), round(position.y),
+               model.alpha, round(transf.scale), transf.getInterpolatedAngle(factor));
+  });
+}
+
+bool TransformationHistorySystem::init(ECSContext& context) {
+  m_access.write(ComponentID::Transformation);
 
-  Bitfield desiredComponents = buildBitfield(ComponentID::Model,
-                                             ComponentID::Transformation);
+  m_transformations = context.registry->createQuery(buildBitfield(ComponentID::Transformation));
 
-  auto entities = registry->findEntities(desiredComponents);
+  return true;
+}
 
-  for(auto entity: entities) {
-    Model* model = registry->getComponent<Model>(entity, ComponentID::Model);
-    Transformation* transf = registry->getComponent<Transformation>(entity, ComponentID::Transformation);
+void TransformationHistorySystem::update(ECSContext& context, real deltaTime) {
+  m_transformations->parallelForEachChunk(*context.jobs, [](Archetype& archetype, ArchetypeChunk& chunk) {
+    Transformation* transformations = chunk.getColumn<Transformation>();
+    for(std::size_t i = 0; i < chunk.size; ++i) {
+      transformations[i].previousPosition = transformations[i].position;
+      transformations[i].previousAngle = transformations[i].angle;
+      transformations[i].hasPrevious = true;
+    }
+  });
+}
 
-    drawSprite(model->sprite, round(transf->position.x), round(transf->position.y),
-               model->alpha, round(transf->scale), transf->angle);
+bool PhysicsIntegrationSystem::init(ECSContext& context) {
+  m_access.read(ComponentID::Bullet)
+          .write(ComponentID::Transformation)
+          .write(ComponentID::Physics);
 
-  }
+  m_bodies = context.registry->createQuery(buildBitfield(ComponentID::Transformation,
+                                                        ComponentID::Physics));
+
+  return true;
 }
 
 void PhysicsIntegrationSystem::update(ECSContext& context, real deltaTime) {
-  Registry* registry = context.registry;
 
-  Bitfield desiredComponents = buildBitfield(ComponentID::Transformation,
-                                             ComponentID::Physics);
+  // NOTE(mizofix): every body is integrated on its own, so chunks go to the jobs
+  m_bodies->parallelForEachChunk(*context.jobs, [&context, deltaTime](Archetype& archetype, ArchetypeChunk& chunk) {
+    Transformation* transformations = chunk.getColumn<Transformation>();
+    Physics* physicsComponents = chunk.getColumn<Physics>();
+    bool isBullet = archetype.getComponents().isSet(int(ComponentID::Bullet));
 
-  EntitiesContainer entities = registry->findEntities(desiredComponents);
-  for(auto entity: entities) {
-    Transformation* transf = registry->getComponent<Transformation>(entity, ComponentID::Transformation);
-    Physics* physics = registry->getComponent<Physics>(entity, ComponentID::Physics);
+    for(std::size_t i = 0; i < chunk.size; ++i) {
+      Transformation* transf = &transformations[i];
+      Physics* physics = &physicsComponents[i];
 
-    physics->transition = false;
+      physics->transition = false;
 
-    vec2 newVelocity = (physics->velocity + physics->acceleration * deltaTime) * physics->damping;
-    real newSpeed = newVelocity.length();
-    real previousSpeed = physics->velocity.length();
-    if(newSpeed <= previousSpeed && newSpeed < 0.01 && !physics->idling) {
-      physics->velocity = vec2();
-      physics->transition = true;
-      physics->idling = true;
-    }
-    else {
-      if(newSpeed >= previousSpeed && newSpeed > 0.01 && physics->idling) {
+      vec2 newVelocity = (physics->velocity + physics->acceleration * deltaTime) * physics->damping;
+      real newSpeed = newVelocity.length();
+      real previousSpeed = physics->velocity.length();
+      if(newSpeed <= previousSpeed && newSpeed < 0.01 && !physics->idling) {
+        physics->velocity = vec2();
         physics->transition = true;
-        physics->idling = false;
+        physics->idling = true;
       }
+      else {
+        if(newSpeed >= previousSpeed && newSpeed > 0.01 && physics->idling) {
+          physics->transition = true;
+          physics->idling = false;
+        }
 
-      if(newSpeed > physics->maxSpeed) {
-        newVelocity.x = (newVelocity.x / newSpeed) * physics->maxSpeed;
-        newVelocity.y = (newVelocity.y / newSpeed) * physics->maxSpeed;
-      }
+        if(newSpeed > physics->maxSpeed) {
+          newVelocity.x = (newVelocity.x / newSpeed) * physics->maxSpeed;
+          newVelocity.y = (newVelocity.y / newSpeed) * physics->maxSpeed;
+        }
 
-      physics->velocity = newVelocity;
-      transf->position += physics->velocity * deltaTime;
-      if(!registry->hasComponent(entity, ComponentID::Bullet)) {
+        physics->velocity = newVelocity;
+        transf->position += physics->velocity * deltaTime;
+        if(!isBullet) {
 
-        if(transf->position.x > context.data.mapWidth * 0.5f) {
-          transf->position.x = context.data.mapWidth * 0.5f;
-        }
-        else if(transf->position.x < -context.data.mapWidth * 0.5f) {
-          transf->position.x = -context.data.mapWidth * 0.5f;
-        }
+          if(transf->position.x > context.data.mapWidth * 0.5f) {
+            transf->position.x = context.data.mapWidth * 0.5f;
+          }
+          else if(transf->position.x < -context.data.mapWidth * 0.5f) {
+            transf->position.x = -context.data.mapWidth * 0.5f;
+          }
 
-        if(transf->position.y > context.data.mapHeight * 0.5f) {
-          transf->position.y = context.data.mapHeight * 0.5f;
-        }
-        else if(transf->position.y < -context.data.mapHeight * 0.5f) {
-          transf->position.y = -context.data.mapHeight * 0.5f;
-        }
+          if(transf->position.y > context.data.mapHeight * 0.5f) {
+            transf->position.y = context.data.mapHeight * 0.5f;
+          }
+          else if(transf->position.y < -context.data.mapHeight * 0.5f) {
+            transf->position.y = -context.data.mapHeight * 0.5f;
+          }
 
+        }
       }
-    }
 
-    physics->acceleration = vec2();
-  }
+      physics->acceleration = vec2();
+    }
+  });
 
 }
 bool EffectsSystem::init(ECSContext& context) {
-  registerMethod(int(MessageType::SPAWN_EFFECT),
-                 &EffectsSystem::onSpawnEffect,
-                 this);
+  // NOTE(mizofix): touches only its own effects and the posted messages
+  m_access.setExclusive(false);
 
   m_maximalEffectsNumber = context.data.maxEffectsNumber;
   return true;
 }
 
 void EffectsSystem::update(ECSContext& context, real deltaTime) {
+  for(const SpawnEffectMessage& message: getMessages<SpawnEffectMessage>()) {
+    spawnEffect(message);
+  }
+
   for(auto effectIt = m_effects.begin(); effectIt != m_effects.end();) {
     effectIt->elapsedTime += deltaTime;
     if(effectIt->elapsedTime >= effectIt->lifetime) {
@@ -914,32 +940,36 @@ void EffectsSystem::draw(ECSContext& context) {
   }
 }
 
-void EffectsSystem::onSpawnEffect(Message message) {
+std::size_t EffectsSystem::getEffectsCount() const {
+  return m_effects.size();
+}
+
+void EffectsSystem::spawnEffect(const SpawnEffectMessage& message) {
 
   Effect newEffect;
-  newEffect.position.x = message.effect_info.x;
-  newEffect.position.y = message.effect_info.y;
-  newEffect.scale = message.effect_info.scale;
-  newEffect.angle = message.effect_info.angle;
-  newEffect.lifetime = message.effect_info.lifetime;
+  newEffect.position = message.position;
+  newEffect.scale = message.scale;
+  newEffect.angle = message.angle;
+  newEffect.lifetime = message.lifetime;
   newEffect.elapsedTime = 0.0f;
-  newEffect.fadeOut = message.effect_info.fadeOut;
+  newEffect.fadeOut = message.fadeOut;
 
   const char* effectName = "";
+  Random& random = getRandom(RandomStream::Effects);
 
-  switch(message.effect_info.type) {
+  switch(message.type) {
   case EffectType::BLOOD:
   {
-    effectName = ((rand() % 2) ? "blood_1" : "blood_2");
+    effectName = ((random.nextInt(2) == 1) ? "blood_1" : "blood_2");
   } break;
   case EffectType::FOOTPRINT: effectName = "footprint"; break;
   case EffectType::BLOODPRINT:{
-    effectName = ((rand() % 2) ? "bloodprint_1" : "bloodprint_2");
+    effectName = ((random.nextInt(2) == 1) ? "bloodprint_1" : "bloodprint_2");
   } break;
   case EffectType::GUN_EXPLOSION: effectName = "gun_explosion"; break;
   case EffectType::ZOMBIE_DEATH:
   {
-    effectName = ((rand() % 2) ? "zombie_death1" :  "zombie_death2");
+    effectName = ((random.nextInt(2) == 1) ? "zombie_death1" :  "zombie_death2");
   } break;
   default: break;
   }
@@ -956,79 +986,130 @@ void EffectsSystem::onSpawnEffect(Message message) {
   }
 }
 
-void PhysicsCollisionSystem::update(ECSContext& context, real deltaTime) {
-  Registry* registry = context.registry;
-  Bitfield desiredComponents = buildBitfield(ComponentID::Transformation,
-                                             ComponentID::Physics);
+PhysicsCollisionSystem::PhysicsCollisionSystem(): m_bodies(nullptr), m_broadphase(nullptr) {
 
-  auto entities = registry->findEntities(desiredComponents);
+}
+
+PhysicsCollisionSystem::~PhysicsCollisionSystem() {
+  delete m_broadphase;
+}
 
-  Message collisionMsg;
-  collisionMsg.type = int(MessageType::ON_COLLISION);
+bool PhysicsCollisionSystem::init(ECSContext& context) {
+  m_access.read(ComponentID::Transformation)
+          .read(ComponentID::Physics);
 
-  for(auto entityAIt = entities.begin(); entityAIt != entities.end(); entityAIt++) {
-    Transformation* transfA = registry->getComponent<Transformation>(*entityAIt,
-                                                                     ComponentID::Transformation);
+  m_bodies = context.registry->createQuery(buildBitfield(ComponentID::Transformation,
+                                                        ComponentID::Physics));
 
-    Physics* physicsA = registry->getComponent<Physics>(*entityAIt, ComponentID::Physics);
+  m_broadphase = createBroadphase(context.data.broadphase);
 
-    for(auto entityBIt = std::next(entityAIt); entityBIt != entities.end(); entityBIt++) {
+  return true;
+}
 
-      if(*entityAIt == *entityBIt) {
-        continue;
+void PhysicsCollisionSystem::update(ECSContext& context, real deltaTime) {
+  m_entities.clear();
+  m_motions.clear();
+  m_bodiesData.clear();
+
+  m_bodies->forEachChunk([this](Archetype& archetype, ArchetypeChunk& chunk) {
+    Transformation* transformations = chunk.getColumn<Transformation>();
+    Physics* physics = chunk.getColumn<Physics>();
+    bool isBullet = archetype.getComponents().isSet(int(ComponentID::Bullet));
+
+    for(std::size_t i = 0; i < chunk.size; ++i) {
+      const Transformation& transf = transformations[i];
+
+      // NOTE(mizofix): a bullet which was created during the last tick has no
+      // previous position, it's tested where it is
+      BodyMotion bodyMotion{transf.position, vec2(), physics[i].size, false};
+      if(isBullet && transf.hasPrevious) {
+        bodyMotion.start = transf.previousPosition;
+        bodyMotion.motion = transf.position - transf.previousPosition;
+        bodyMotion.isSwept = true;
       }
 
-      Transformation* transfB = registry->getComponent<Transformation>(*entityBIt,
-                                                                       ComponentID::Transformation);
+      vec2 center = bodyMotion.start + bodyMotion.motion * 0.5f;
+      real radius = bodyMotion.radius + bodyMotion.motion.length() * 0.5f;
 
-      Physics* physicsB = registry->getComponent<Physics>(*entityBIt, ComponentID::Physics);
+      m_entities.push_back(chunk.entities[i]);
+      m_motions.push_back(bodyMotion);
+      m_bodiesData.add(center.x, center.y, radius, getEntityIndex(chunk.entities[i]),
+                       physics[i].collisionLayer, physics[i].collisionMask);
+    }
+  });
 
-      real distanceAtoB = transfA->position.distance(transfB->position);
-      if(distanceAtoB < physicsA->size + physicsB->size) {
-        collisionMsg.collision_info.entityA = *entityAIt;
-        collisionMsg.collision_info.entityB = *entityBIt;
+  m_broadphase->findPairs(m_bodiesData, m_pairs);
 
-        notify(collisionMsg);
-      }
+  m_collisions.clear();
+  for(const BroadphasePair& pair: m_pairs) {
+    const BodyMotion& motionA = m_motions[pair.a];
+    const BodyMotion& motionB = m_motions[pair.b];
+
+    // NOTE(mizofix): circles around the motions overlap, but the bodies might have
+    // missed each other
+    real time = 1.0f;
+    if((motionA.isSwept || motionB.isSwept) &&
+       !findTimeOfImpact(motionA.start - motionB.start, motionA.motion - motionB.motion,
+                         motionA.radius + motionB.radius, time)) {
+      continue;
+    }
+
+    m_collisions.push_back(Collision{pair, time});
+  }
 
+  // NOTE(mizofix): collisions (and so the penetration resolution) come in the same
+  // order with every broadphase
+  std::sort(m_collisions.begin(), m_collisions.end(), [](const Collision& collisionA, const Collision& collisionB) {
+    if(collisionA.time != collisionB.time) {
+      return collisionA.time < collisionB.time;
     }
+
+    return (collisionA.pair.a != collisionB.pair.a) ? collisionA.pair.a < collisionB.pair.a :
+                                                      collisionA.pair.b < collisionB.pair.b;
+  });
+
+  CollisionMessage collisionMsg;
+  for(const Collision& collision: m_collisions) {
+    collisionMsg.entityA = m_entities[collision.pair.a];
+    collisionMsg.entityB = m_entities[collision.pair.b];
+    collisionMsg.time = collision.time;
+
+    post(collisionMsg);
   }
 }
 
 bool PenetrationResolutionSystem::init(ECSContext& context) {
-  registerMethod<PenetrationResolutionSystem>(int(MessageType::ON_COLLISION),
-                                              &PenetrationResolutionSystem::onCollision,
-                                              this);
+  m_access.read(ComponentID::Bullet)
+          .read(ComponentID::Physics)
+          .write(ComponentID::Transformation);
 
   return true;
 }
 
 void PenetrationResolutionSystem::update(ECSContext& context, real deltaTime) {
   Registry* registry = context.registry;
+  Bitset bodyComponents = buildBitfield(ComponentID::Transformation, ComponentID::Physics);
 
-  for(auto collision: m_unprocessedCollisions) {
-    if(registry->hasComponent(collision.collision_info.entityA, ComponentID::Bullet) ||
-       registry->hasComponent(collision.collision_info.entityB, ComponentID::Bullet)) {
-      continue;
+  forEachCollision(registry, bodyComponents, bodyComponents, [&](Entity entityA, Entity entityB) {
+    if(registry->hasComponent<Bullet>(entityA) || registry->hasComponent<Bullet>(entityB)) {
+      return;
     }
 
-    Transformation* transfA = registry->getComponent<Transformation>(collision.collision_info.entityA,
-                                                                     ComponentID::Transformation);
+    Transformation* transfA = registry->getComponent<Transformation>(entityA);
 
-    Physics* physicsA = registry->getComponent<Physics>(collision.collision_info.entityA,
-                                                        ComponentID::Physics);
+    Physics* physicsA = registry->getComponent<Physics>(entityA);
 
-    Transformation* transfB = registry->getComponent<Transformation>(collision.collision_info.entityB,
-                                                                     ComponentID::Transformation);
-    Physics* physicsB = registry->getComponent<Physics>(collision.collision_info.entityB,
-                                                        ComponentID::Physics);
+    Transformation* transfB = registry->getComponent<Transformation>(entityB);
+    Physics* physicsB = registry->getComponent<Physics>(entityB);
 
 
     real distance = (transfB->position - transfA->position).length();
     real totalSize = physicsA->size + physicsB->size;
     vec2 direction = (transfB->position - transfA->position);
 
-    if(distance > 0.01) {
+    // NOTE(mizofix): the collision is of the last tick, the bodies might have been
+    // moved apart since then
+    if(distance > 0.01 && distance < totalSize) {
       direction.x /= distance;
       direction.y /= distance;
 
@@ -1039,19 +1120,16 @@ void PenetrationResolutionSystem::update(ECSContext& context, real deltaTime) {
       transfA->position -= direction * ((totalSize - distance) * percentA);
       transfB->position += direction * ((totalSize - distance) * (1.0f - percentA));
     }
-  }
-
-  m_unprocessedCollisions.clear();
-}
-
-void PenetrationResolutionSystem::onCollision(Message message) {
-  m_unprocessedCollisions.push_back(message);
+  });
 }
 
 bool BulletSystem::init(ECSContext& context) {
-  registerMethod<BulletSystem>(int(MessageType::ON_COLLISION),
-                               &BulletSystem::onCollision,
-                               this);
+  m_access.read(ComponentID::Transformation)
+          .read(ComponentID::Zombie)
+          .write(ComponentID::Bullet)
+          .write(ComponentID::Attributes);
+
+  m_bullets = context.registry->createQuery(buildBitfield(ComponentID::Bullet));
 
   return true;
 }
@@ -1059,56 +1137,47 @@ bool BulletSystem::init(ECSContext& context) {
 void BulletSystem::update(ECSContext& context, real deltaTime) {
 
   Registry* registry = context.registry;
+  CommandBuffer* commands = context.commands;
 
-  for(auto collision: m_unprocessedCollisions) {
-    Entity bullet = Constants::INVALID_ENTITY;
-    Entity object = Constants::INVALID_ENTITY;
+  forEachCollision(registry, buildBitfield(ComponentID::Bullet), buildBitfield(ComponentID::Zombie),
+                   [&](Entity bullet, Entity zombie) {
+    Bullet* bulletComponent = registry->getComponent<Bullet>(bullet);
 
-    if(registry->hasComponent(collision.collision_info.entityA, ComponentID::Bullet)) {
-      bullet = collision.collision_info.entityA;
-      object = collision.collision_info.entityB;
+    // NOTE(mizofix): the bullet is destroyed at the end of the frame, so it
+    // may still collide with something else in this one. Collisions come in the
+    // order of time, so the zombies which it met first take the hits
+    if(bulletComponent->durability <= 0) {
+      return;
     }
-    else if(registry->hasComponent(collision.collision_info.entityB, ComponentID::Bullet)) {
-      bullet = collision.collision_info.entityB;
-      object = collision.collision_info.entityA;
-    }
-
-    if(bullet != Constants::INVALID_ENTITY && registry->hasComponent(object, ComponentID::Zombie)) {
-      Bullet* bulletComponent = registry->getComponent<Bullet>(bullet, ComponentID::Bullet);
-      Attributes* zombieAttributes = registry->getComponent<Attributes>(object, ComponentID::Attributes);
-      zombieAttributes->health -= bulletComponent->damage;
 
-      Transformation* zombieTransf = registry->getComponent<Transformation>(object, ComponentID::Transformation);
+    Attributes* zombieAttributes = registry->getComponent<Attributes>(zombie);
+    zombieAttributes->health -= bulletComponent->damage;
 
-      generateEffect(EffectType::BLOOD, zombieTransf->position, 1.0f, zombieTransf->angle, 3.0f, true);
-      generateEffect(EffectType::BLOODPRINT, zombieTransf->position, 1.0f, zombieTransf->angle, 7.0f, true);
-
-      bulletComponent->durability--;
-      if(bulletComponent->durability <= 0) {
-        registry->destroyEntity(bullet);
-      }
+    Transformation* zombieTransf = registry->getComponent<Transformation>(zombie);
 
+    generateEffect(EffectType::BLOOD, zombieTransf->position, 1.0f, zombieTransf->angle, 3.0f, true);
+    generateEffect(EffectType::BLOODPRINT, zombieTransf->position, 1.0f, zombieTransf->angle, 7.0f, true);
 
+    bulletComponent->durability--;
+    if(bulletComponent->durability <= 0) {
+      commands->destroyEntity(bullet);
     }
+  });
 
-  }
-
-  Bitfield desiredComponents = buildBitfield(ComponentID::Bullet);
-  auto bullets = registry->findEntities(desiredComponents);
-  for(auto bullet: bullets) {
-    Bullet* bulletComponent = registry->getComponent<Bullet>(bullet, ComponentID::Bullet);
-    bulletComponent->elapsedTime += deltaTime;
+  m_bullets->each<Bullet>([&](Entity bullet, Bullet& bulletComponent) {
+    bulletComponent.elapsedTime += deltaTime;
 
-    if(bulletComponent->elapsedTime > bulletComponent->lifetime) {
-      registry->destroyEntity(bullet);
+    if(bulletComponent.elapsedTime > bulletComponent.lifetime) {
+      commands->destroyEntity(bullet);
     }
-  }
-
-  m_unprocessedCollisions.clear();
+  });
 }
 
-void BulletSystem::onCollision(Message message) {
-  m_unprocessedCollisions.push_back(message);
+UIRenderingSystem::UIRenderingSystem(const SystemManager* systemManager): m_systemManager(systemManager),
+                                                                         m_overlayVisible(false),
+                                                                         m_frameTimesCount(0),
+                                                                         m_nextFrameTime(0) {
+
 }
 
 UIRenderingSystem::~UIRenderingSystem() {
@@ -1147,17 +1216,26 @@ bool UIRenderingSystem::init(ECSContext& context) {
   setSpriteAnchorPoint(m_weaponSprite, 0.0f, 0.0f);
   m_lastDeltaTime = 0.0f;
 
+  Registry* registry = context.registry;
+  m_players = registry->createQuery(buildBitfield(ComponentID::Player, ComponentID::Attributes));
+  m_zombies = registry->createQuery(buildBitfield(ComponentID::Transformation, ComponentID::Zombie));
+  m_boxes = registry->createQuery(buildBitfield(ComponentID::Transformation, ComponentID::Weapon));
+  m_trails = registry->createQuery(buildBitfield(ComponentID::Trail));
+
   return true;
 }
 
+void UIRenderingSystem::toggleOverlay() {
+  m_overlayVisible = !m_overlayVisible;
+}
+
 
 void UIRenderingSystem::update(ECSContext& context, real deltaTime) {
 
   Registry* registry = context.registry;
-  Bitfield desiredComponents = buildBitfield(ComponentID::Player);
-  Entity player = getPlayer(registry, desiredComponents);
+  Entity player = getPlayer(m_players);
 
-  Player* playerComponent = registry->getComponent<Player>(player, ComponentID::Player);
+  Player* playerComponent = registry->getComponent<Player>(player);
 
   WeaponType currentWeapon = playerComponent->weapons[playerComponent->currentWeaponIndex].type;
   if(currentWeapon == WeaponType::KNIFE) {
@@ -1174,17 +1252,27 @@ void UIRenderingSystem::update(ECSContext& context, real deltaTime) {
   }
 
   m_lastDeltaTime = deltaTime;
+
+  // NOTE(mizofix): frames of the intermission after the death have zero time
+  if(deltaTime > 0.0f) {
+    m_frameTimes[m_nextFrameTime] = deltaTime * 1000.0f;
+    m_nextFrameTime = (m_nextFrameTime + 1) % OVERLAY_FRAMES_COUNT;
+    m_frameTimesCount = std::min(m_frameTimesCount + 1, OVERLAY_FRAMES_COUNT);
+  }
 }
 
 void UIRenderingSystem::draw(ECSContext& context) {
 
+  if(m_overlayVisible) {
+    drawOverlay(context);
+  }
+
   Registry* registry = context.registry;
 
-  Bitfield desiredComponents = buildBitfield(ComponentID::Player, ComponentID::Attributes);
-  Entity player = getPlayer(registry, desiredComponents);
-  Player* playerComponent = registry->getComponent<Player>(player, ComponentID::Player);
-  Attributes* playerAttributes = registry->getComponent<Attributes>(player, ComponentID::Attributes);
-  Transformation* playerTransform = registry->getComponent<Transformation>(player, ComponentID::Transformation);
+  Entity player = getPlayer(m_players);
+  Player* playerComponent = registry->getComponent<Player>(player);
+  Attributes* playerAttributes = registry->getComponent<Attributes>(player);
+  Transformation* playerTransform = registry->getComponent<Transformation>(player);
 
   if(playerAttributes->isDead) {
     char textBuffer[64];
@@ -1250,37 +1338,28 @@ void UIRenderingSystem::draw(ECSContext& context) {
              128, 0.2f, 0.0f, false);
 
 
-  Bitfield zombieComponents = buildBitfield(ComponentID::Transformation, ComponentID::Zombie);
-  Bitfield boxesComponents = buildBitfield(ComponentID::Transformation, ComponentID::Weapon);
-
   // NOTE(mizofix): Rendering circles on radar
-  auto zombies = registry->findEntities(zombieComponents);
-  for(auto zombie: zombies) {
-    Transformation* zombieTransf = registry->getComponent<Transformation>(zombie,
-                                                                          ComponentID::Transformation);
+  m_zombies->each<Transformation>([&](Entity zombie, Transformation& zombieTransf) {
 
     vec2 convertedPosition = convertToRadarCoords(radarGlobalCenter, radarRadius, maxRadarDistance,
-                                                  zombieTransf->position, playerTransform->position);
+                                                  zombieTransf.position, playerTransform->position);
 
     drawSprite(m_xiconSprite, int(convertedPosition.x), int(convertedPosition.y),
-               128, 1.0f, zombieTransf->angle, false);
+               128, 1.0f, zombieTransf.angle, false);
 
 
-  }
+  });
 
   // NOTE(mizofix): Rendering boxes on radar
-  auto boxes = registry->findEntities(boxesComponents);
-  for(auto box: boxes) {
-    Transformation* boxTransf = registry->getComponent<Transformation>(box,
-                                                                       ComponentID::Transformation);
+  m_boxes->each<Transformation>([&](Entity box, Transformation& boxTransf) {
 
     vec2 convertedPosition = convertToRadarCoords(radarGlobalCenter, radarRadius, maxRadarDistance,
-                                                  boxTransf->position, playerTransform->position);
+                                                  boxTransf.position, playerTransform->position);
 
     drawSprite(m_circleSprite, int(convertedPosition.x), int(convertedPosition.y),
                128, 1.0f, 0.0f, false);
 
-  }
+  });
 
   // NOTE(mizofix): Rendering a player on radar
   drawSprite(m_arrowSprite, int(radarGlobalCenter.x), int(radarGlobalCenter.y),
@@ -1345,3 +1424,163 @@ vec2 UIRenderingSystem::convertToRadarCoords(const vec2& radarPosition, real rad
 
   return convertedPosition;
 }
+
+const static int  OVERLAY_LINE_HEIGHT = 20;
+const static int  OVERLAY_GRAPH_HEIGHT = 60;
+
+// NOTE(mizofix): frame time which fills the whole height of the graph
+const static real OVERLAY_GRAPH_TIME = 50.0f;
+const static real OVERLAY_TARGET_FRAME_TIME = 1000.0f / 60.0f;
+
+// NOTE(mizofix): frames which are this many times longer than the median are spikes
+const static real OVERLAY_SPIKE_FACTOR = 2.0f;
+
+const static std::size_t OVERLAY_ARCHETYPES_COUNT = 5;
+
+void UIRenderingSystem::drawOverlay(ECSContext& context) {
+  // NOTE(mizofix): the overlay itself isn't counted
+  unsigned int drawCallsCount = getDrawCallsCount();
+
+  int x = 10;
+  int y = 160;
+
+  drawRect(x - 5, y - 5, 420, context.data.windowHeight - y, 255, 255, 255, 160, 0.0f, 0.0f, false);
+
+  y = drawFrameTimes(x, y);
+
+  char textBuffer[128];
+  sprintf(textBuffer, "Draw calls: %u", drawCallsCount);
+  drawText(textBuffer, x, y, 0.0f, 0.0f, 0, 0, 0, false);
+  y += OVERLAY_LINE_HEIGHT;
+
+  y = drawEntitiesStats(context, x, y);
+  y = drawSystemsStats(x, y);
+  drawMessagesStats(x, y);
+}
+
+int UIRenderingSystem::drawFrameTimes(int x, int y) {
+  if(m_frameTimesCount == 0) {
+    return y;
+  }
+
+  std::array<real, OVERLAY_FRAMES_COUNT> sortedTimes = m_frameTimes;
+  std::sort(sortedTimes.begin(), sortedTimes.begin() + m_frameTimesCount);
+
+  real medianTime = sortedTimes[(m_frameTimesCount - 1) * 50 / 100];
+  real p99Time = sortedTimes[(m_frameTimesCount - 1) * 99 / 100];
+  real maxTime = sortedTimes[m_frameTimesCount - 1];
+  real spikeTime = medianTime * OVERLAY_SPIKE_FACTOR;
+
+  int spikesCount = 0;
+  for(std::size_t i = 0; i < m_frameTimesCount; ++i) {
+    spikesCount += (m_frameTimes[i] > spikeTime) ? 1 : 0;
+  }
+
+  char textBuffer[128];
+  sprintf(textBuffer, "Frame p50 %.2f ms, p99 %.2f ms, max %.2f ms, spikes %d",
+          medianTime, p99Time, maxTime, spikesCount);
+  drawText(textBuffer, x, y, 0.0f, 0.0f, 0, 0, 0, false);
+  y += OVERLAY_LINE_HEIGHT + 4;
+
+  // NOTE(mizofix): the oldest frame is on the left, spikes are red
+  drawRect(x, y, int(OVERLAY_FRAMES_COUNT), OVERLAY_GRAPH_HEIGHT, 64, 64, 64, 96, 0.0f, 0.0f, false);
+
+  int graphBottom = y + OVERLAY_GRAPH_HEIGHT;
+  std::size_t firstFrame = (m_nextFrameTime + OVERLAY_FRAMES_COUNT - m_frameTimesCount) % OVERLAY_FRAMES_COUNT;
+  for(std::size_t i = 0; i < m_frameTimesCount; ++i) {
+    real frameTime = m_frameTimes[(firstFrame + i) % OVERLAY_FRAMES_COUNT];
+    int barHeight = int(std::min(frameTime / OVERLAY_GRAPH_TIME, 1.0f) * OVERLAY_GRAPH_HEIGHT);
+    bool isSpike = frameTime > spikeTime;
+
+    drawRect(x + int(i), graphBottom - barHeight, 1, barHeight,
+             isSpike ? 220 : 40, isSpike ? 40 : 160, 40, 255, 0.0f, 0.0f, false);
+  }
+
+  int targetY = graphBottom - int(OVERLAY_TARGET_FRAME_TIME / OVERLAY_GRAPH_TIME * OVERLAY_GRAPH_HEIGHT);
+  drawRect(x, targetY, int(OVERLAY_FRAMES_COUNT), 1, 0, 0, 0, 192, 0.0f, 0.0f, false);
+
+  return graphBottom + 4;
+}
+
+int UIRenderingSystem::drawSystemsStats(int x, int y) {
+  char textBuffer[128];
+
+  drawText("System: update / draw, ms", x, y, 0.0f, 0.0f, 0, 0, 0, false);
+  y += OVERLAY_LINE_HEIGHT;
+
+  m_systemManager->getSystemsStats(m_systemsStats);
+  for(const SystemStats& stats: m_systemsStats) {
+    sprintf(textBuffer, "  %.40s: %.3f / %.3f",
+            stats.system->getName().c_str(), stats.updateTime, stats.drawTime);
+    drawText(textBuffer, x, y, 0.0f, 0.0f, 0, 0, 0, false);
+    y += OVERLAY_LINE_HEIGHT;
+  }
+
+  return y;
+}
+
+int UIRenderingSystem::drawEntitiesStats(ECSContext& context, int x, int y) {
+  char textBuffer[256];
+
+  std::vector<const Archetype*> archetypes(context.registry->getArchetypes().begin(),
+                                           context.registry->getArchetypes().end());
+
+  std::size_t entitiesCount = 0;
+  for(const Archetype* archetype: archetypes) {
+    entitiesCount += archetype->getSize();
+  }
+
+  std::size_t particlesCount = 0;
+  m_trails->each<Trail>([&particlesCount](Entity trail, Trail& trailComponent) {
+    particlesCount += trailComponent.particles.size();
+  });
+
+  const EffectsSystem* effectsSystem = dynamic_cast<const EffectsSystem*>(m_systemManager->getSystem("effects_system"));
+  std::size_t effectsCount = (effectsSystem != nullptr) ? effectsSystem->getEffectsCount() : 0;
+
+  sprintf(textBuffer, "Entities %zu, effects %zu, trail particles %zu",
+          entitiesCount, effectsCount, particlesCount);
+  drawText(textBuffer, x, y, 0.0f, 0.0f, 0, 0, 0, false);
+  y += OVERLAY_LINE_HEIGHT;
+
+  std::size_t shownCount = std::min(archetypes.size(), OVERLAY_ARCHETYPES_COUNT);
+  std::partial_sort(archetypes.begin(), archetypes.begin() + shownCount, archetypes.end(),
+                    [](const Archetype* a, const Archetype* b) {
+                      return a->getSize() > b->getSize();
+                    });
+
+  for(std::size_t i = 0; i < shownCount && archetypes[i]->getSize() > 0; ++i) {
+    int length = sprintf(textBuffer, "  %zu:", archetypes[i]->getSize());
+    for(std::size_t component = 0; component < std::size_t(ComponentID::COUNT); ++component) {
+      if(archetypes[i]->getComponents().isSet(component) && length < 200) {
+        length += sprintf(textBuffer + length, " %s", getComponentName(ComponentID(component)));
+      }
+    }
+
+    drawText(textBuffer, x, y, 0.0f, 0.0f, 0, 0, 0, false);
+    y += OVERLAY_LINE_HEIGHT;
+  }
+
+  return y;
+}
+
+int UIRenderingSystem::drawMessagesStats(int x, int y) {
+  char textBuffer[128];
+
+  drawText("Messages in the frame:", x, y, 0.0f, 0.0f, 0, 0, 0, false);
+  y += OVERLAY_LINE_HEIGHT;
+
+  for(int type = 0; type < int(MessageType::COUNT); ++type) {
+    const MessageStats& stats = getMessageFrameStats(type);
+
+    if(stats.emittedCount > 0 || stats.deliveredCount > 0) {
+      sprintf(textBuffer, "  %s: %llu sent, %llu delivered, %.3f ms", getMessageTypeName(type),
+              (unsigned long long)stats.emittedCount, (unsigned long long)stats.deliveredCount,
+              double(stats.handlersTime) / 1000000.0);
+      drawText(textBuffer, x, y, 0.0f, 0.0f, 0, 0, 0, false);
+      y += OVERLAY_LINE_HEIGHT;
+    }
+  }
+
+  return y;
+}
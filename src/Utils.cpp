@@ -1,7 +1,9 @@
 #include "Utils.h"
+#include "Broadphase.h"
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include <ctime>
 
 const static char* line = "-------------------------\n";
 const static char* error_header = "[error]";
@@ -27,6 +29,10 @@ const static int MAX_REGEN = 10000;
 
 const static int MIN_EFFECTS = 0;
 const static int MAX_EFFECTS = 10000;
+const static int MAX_THREADS = 64;
+const static int MIN_SIMULATION_RATE = 10;
+const static int MAX_SIMULATION_RATE = 240;
+const static int MAX_HEADLESS_TICKS = 10000000;
 
 const static int MIN_ROUND = 1;
 const static int MAX_ROUND = 10;
@@ -67,6 +73,18 @@ WorldData parseCommands(int argc, char** commands) {
   result.roundData.roundTime = 10.0f;
   result.roundData.currentRoundNumber = 1;
   result.roundData.intermissionActivated = true;
+  result.threadsCount = 0;
+  result.simulationRate = 60;
+  result.headlessTicks = 0;
+  result.profilePath = nullptr;
+  result.seed = uint32_t(time(nullptr));
+  result.recordPath = nullptr;
+  result.replayPath = nullptr;
+  result.messageStatsPath = nullptr;
+  result.broadphase = BroadphaseType::GRID;
+  result.collisionBenchmark = false;
+  result.queryBenchmark = false;
+  result.jobsBenchmark = false;
 
   int i = 1;
   while(i < argc) {
@@ -95,6 +113,29 @@ WorldData parseCommands(int argc, char** commands) {
              "  (minimal %d maximal %d)\n", MIN_EFFECTS, MAX_EFFECTS);
       printf(" -start_round [num] - to set initial round number\n"
              "  (minimal %d maximal %d)\n", MIN_ROUND, MAX_ROUND);
+      printf(" -threads [num] - to set number of threads used for updating the world\n"
+             "  (0 - one per hardware thread, maximal %d)\n", MAX_THREADS);
+      printf(" -sim_rate [num] - to set number of simulation ticks per second\n"
+             "  (minimal %d maximal %d)\n", MIN_SIMULATION_RATE, MAX_SIMULATION_RATE);
+      printf(" -headless [num] - to simulate num frames without a window (a tick per frame with\n"
+             "  scripted input unless it's replayed), ticks per second are printed at the end\n"
+             "  (maximal %d)\n", MAX_HEADLESS_TICKS);
+      printf(" -profile [file] - to write the profiler trace (Chrome trace format) into the file\n"
+             "  at exit, it's also written on [P] (to %s by default)\n", DEFAULT_PROFILE_PATH);
+      printf(" -seed [num] - to set seed of the random numbers (by default it depends on the time)\n");
+      printf(" -record [file] - to record the input of the game into the file\n");
+      printf(" -replay [file] - to replay the recorded game, its settings replace the given ones.\n"
+             "  The game stops when the replay is over\n");
+      printf(" -message_stats [file] - to write numbers of messages of every type and time spent\n"
+             "  in their handlers for every frame into the file (CSV)\n");
+      printf(" -broadphase [grid|sap] - to set the search of collisions: uniform grid or sweep\n"
+             "  and prune (grid by default)\n");
+      printf(" -bench_collisions - to benchmark the broadphases on the map with up to 20000\n"
+             "  random moving bodies instead of running the game\n");
+      printf(" -bench_queries - to benchmark walks over queries against findEntities() with up\n"
+             "  to 10000 entities instead of running the game\n");
+      printf(" -bench_jobs - to benchmark updates of 100000 transformations split between jobs\n"
+             "  with 1 to -threads threads instead of running the game\n");
 
       exit(0);
     }
@@ -178,6 +219,58 @@ WorldData parseCommands(int argc, char** commands) {
       result.roundData.currentRoundNumber = clamp(atoi(commands[i + 1]), MIN_ROUND, MAX_ROUND);
       i += 2;
     }
+    else if(strCaseCmp(commands[i], "-threads") == 0 && isNotLast) {
+      result.threadsCount = clamp(atoi(commands[i + 1]), 0, MAX_THREADS);
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-profile") == 0 && isNotLast) {
+      result.profilePath = commands[i + 1];
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-headless") == 0 && isNotLast) {
+      result.headlessTicks = clamp(atoi(commands[i + 1]), 1, MAX_HEADLESS_TICKS);
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-seed") == 0 && isNotLast) {
+      result.seed = uint32_t(strtoul(commands[i + 1], nullptr, 10));
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-record") == 0 && isNotLast) {
+      result.recordPath = commands[i + 1];
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-replay") == 0 && isNotLast) {
+      result.replayPath = commands[i + 1];
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-message_stats") == 0 && isNotLast) {
+      result.messageStatsPath = commands[i + 1];
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-broadphase") == 0 && isNotLast) {
+      for(int type = 0; type < int(BroadphaseType::COUNT); ++type) {
+        if(strCaseCmp(commands[i + 1], getBroadphaseName(BroadphaseType(type))) == 0) {
+          result.broadphase = BroadphaseType(type);
+        }
+      }
+      i += 2;
+    }
+    else if(strCaseCmp(commands[i], "-bench_collisions") == 0) {
+      result.collisionBenchmark = true;
+      i += 1;
+    }
+    else if(strCaseCmp(commands[i], "-bench_queries") == 0) {
+      result.queryBenchmark = true;
+      i += 1;
+    }
+    else if(strCaseCmp(commands[i], "-bench_jobs") == 0) {
+      result.jobsBenchmark = true;
+      i += 1;
+    }
+    else if(strCaseCmp(commands[i], "-sim_rate") == 0 && isNotLast) {
+      result.simulationRate = clamp(atoi(commands[i + 1]), MIN_SIMULATION_RATE, MAX_SIMULATION_RATE);
+      i += 2;
+    }
 
     else {
       info("%s command '%s' is undefined.\n", error_header, commands[i]);
@@ -188,7 +281,3 @@ WorldData parseCommands(int argc, char** commands) {
 
   return result;
 }
-
-real randomReal(real start, real end) {
-  return drand48() * (end - start) + start;
-}
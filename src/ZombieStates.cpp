@@ -1,18 +1,19 @@
 #include "ZombieStates.h"
 #include "Message.h"
 #include "Components.h"
+#include "Random.h"
 
 void ZombieIdle::onEnter(ECSContext& context, Entity zombie) {
   Registry* registry = context.registry;
-  Model* model = registry->getComponent<Model>(zombie, ComponentID::Model);
+  Model* model = registry->getComponent<Model>(zombie);
   setAnimation(model->sprite, "zombie_idle");
   setFrozenAnimation(model->sprite, false);
 }
 
 void ZombieIdle::update(ECSContext& context, Entity zombie, real deltaTime) {
   Registry* registry = context.registry;
-  Physics* physics = registry->getComponent<Physics>(zombie, ComponentID::Physics);
-  Model* model = registry->getComponent<Model>(zombie, ComponentID::Model);
+  Physics* physics = registry->getComponent<Physics>(zombie);
+  Model* model = registry->getComponent<Model>(zombie);
   updateAnimation(model->sprite, deltaTime);
 
   if(!physics->idling) {
@@ -22,17 +23,17 @@ void ZombieIdle::update(ECSContext& context, Entity zombie, real deltaTime) {
 
 void ZombieWalk::onEnter(ECSContext& context, Entity zombie) {
   Registry* registry = context.registry;
-  Model* model = registry->getComponent<Model>(zombie, ComponentID::Model);
+  Model* model = registry->getComponent<Model>(zombie);
 
   char animationName[32];
-  sprintf(animationName, "zombie_walk%d", rand() % 2 + 1);
+  sprintf(animationName, "zombie_walk%d", getRandom(RandomStream::Zombies).nextInt(2) + 1);
   setAnimation(model->sprite, animationName);
 }
 
 void ZombieWalk::update(ECSContext& context, Entity zombie, real deltaTime) {
   Registry* registry = context.registry;
-  Physics* physics = registry->getComponent<Physics>(zombie, ComponentID::Physics);
-  Model* model = registry->getComponent<Model>(zombie, ComponentID::Model);
+  Physics* physics = registry->getComponent<Physics>(zombie);
+  Model* model = registry->getComponent<Model>(zombie);
   updateAnimation(model->sprite, deltaTime);
 
   if(physics->idling) {
@@ -42,35 +43,33 @@ void ZombieWalk::update(ECSContext& context, Entity zombie, real deltaTime) {
 
 void ZombieAttack::onEnter(ECSContext& context, Entity zombie) {
   Registry* registry = context.registry;
-  Model* model = registry->getComponent<Model>(zombie, ComponentID::Model);
-  Zombie* zombieComponent = registry->getComponent<Zombie>(zombie, ComponentID::Zombie);
+  Model* model = registry->getComponent<Model>(zombie);
+  Zombie* zombieComponent = registry->getComponent<Zombie>(zombie);
   zombieComponent->attacking = true;
 
   char animationName[32];
-  sprintf(animationName, "zombie_attack%d", rand() % 3 + 1);
+  sprintf(animationName, "zombie_attack%d", getRandom(RandomStream::Zombies).nextInt(3) + 1);
   setAnimation(model->sprite, animationName);
 }
 
 void ZombieAttack::update(ECSContext& context, Entity zombie, real deltaTime) {
   Registry* registry = context.registry;
-  Physics* physics = registry->getComponent<Physics>(zombie, ComponentID::Physics);
-  Model* model = registry->getComponent<Model>(zombie, ComponentID::Model);
-  Zombie* zombieComponent = registry->getComponent<Zombie>(zombie, ComponentID::Zombie);
+  Physics* physics = registry->getComponent<Physics>(zombie);
+  Model* model = registry->getComponent<Model>(zombie);
+  Zombie* zombieComponent = registry->getComponent<Zombie>(zombie);
   updateAnimation(model->sprite, deltaTime);
 
   if(isAnimationFinished(model->sprite)) {
 
-    Transformation* transform = registry->getComponent<Transformation>(zombie, ComponentID::Transformation);
-    Attributes* attributes = registry->getComponent<Attributes>(zombie, ComponentID::Attributes);
+    Transformation* transform = registry->getComponent<Transformation>(zombie);
+    Attributes* attributes = registry->getComponent<Attributes>(zombie);
 
-    Message msg;
-    msg.type = int(MessageType::ZOMBIE_ATTACK);
-    msg.attack_info.x = transform->position.x;
-    msg.attack_info.y = transform->position.y;
-    msg.attack_info.angle = transform->angle;
-    msg.attack_info.damage = attributes->damage;
+    ZombieAttackMessage msg;
+    msg.position = transform->position;
+    msg.angle = transform->angle;
+    msg.damage = attributes->damage;
 
-    notify(msg);
+    post(msg);
 
     zombieComponent->attacking = false;
     if(physics->idling) {
@@ -5,10 +5,32 @@
 #include <GL/gl.h>
 
 #include "ecs/Registry.h"
-
-CrimsonlandFramework::CrimsonlandFramework(int argc, char** commands): m_lastTime(0.0f) {
+#include "Profiler.h"
+#include "Narrowphase.h"
+#include "Benchmarks.h"
+#include "Random.h"
+
+CrimsonlandFramework::CrimsonlandFramework(int argc, char** commands): m_done(false),
+                                                                      m_jobs(nullptr),
+                                                                      m_lastTime(0.0f),
+                                                                      m_deltaTime(0.0f),
+                                                                      m_simulationAccumulator(0.0f),
+                                                                      m_simulationTicksCount(0),
+                                                                      m_headlessTick(0),
+                                                                      m_frameMouseWheel(0) {
   m_worldData = parseCommands(argc, commands);
 
+  // NOTE(mizofix): the replay is opened here, since its settings are needed before Init()
+  if(m_worldData.replayPath != nullptr) {
+    if(m_replayReader.open(m_worldData.replayPath)) {
+      applyReplayHeader(m_replayReader.getHeader(), m_worldData);
+    } else {
+      printf("[error] can't read replay %s\n", m_worldData.replayPath);
+    }
+  }
+
+  m_simulationStep = 1.0f / float(m_worldData.simulationRate);
+
   info("-------------------------\n");
   info("final world data values are:\n");
   info("Window size (%d, %d)\n", m_worldData.windowWidth, m_worldData.windowHeight);
@@ -21,6 +43,10 @@ CrimsonlandFramework::CrimsonlandFramework(int argc, char** commands): m_lastTim
   info("Stamina regen speed %d\n", int(m_worldData.staminaRegenSpeed));
   info("Maximal effects number %d\n", int(m_worldData.maxEffectsNumber));
   info("Initial round %d\n", int(m_worldData.roundData.currentRoundNumber));
+  info("Threads %u (0 - one per hardware thread)\n", m_worldData.threadsCount);
+  info("Simulation rate %u\n", m_worldData.simulationRate);
+  info("Seed %u\n", m_worldData.seed);
+  info("Broadphase %s\n", getBroadphaseName(m_worldData.broadphase));
   info("-------------------------\n");
 
 }
@@ -33,15 +59,17 @@ void CrimsonlandFramework::PreInit(int& width, int& height, bool& fullscreen) {
 
 bool CrimsonlandFramework::Init() {
 
-  // TODO(mizofix): Get rid of GLAD
-  if(!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
-    return false;
+  if(!isHeadless()) {
+    // TODO(mizofix): Get rid of GLAD
+    if(!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
+      return false;
 
-  }
-  if(!m_bumpProgram.generateProgram("shaders/posteffect.vert",
-                                    "shaders/bumpeffect.frag")) {
-    info("%s\n", m_bumpProgram.getErrorMessage().c_str());
-    return false;
+    }
+    if(!m_bumpProgram.generateProgram("shaders/posteffect.vert",
+                                      "shaders/bumpeffect.frag")) {
+      info("%s\n", m_bumpProgram.getErrorMessage().c_str());
+      return false;
+    }
   }
 
   if(!loadAnimations("data/animations.json") ||
@@ -51,21 +79,50 @@ bool CrimsonlandFramework::Init() {
   }
   showCursor(false);
 
-  m_background = createSprite("sand");
+  std::size_t workersCount = JobSystem::getDefaultWorkersCount();
+  if(m_worldData.threadsCount > 0) {
+    workersCount = m_worldData.threadsCount - 1;
+  }
+
+  m_jobs = new JobSystem(workersCount);
+
+  if(m_worldData.replayPath != nullptr && !m_replayReader.isOpen()) {
+    return false;
+  }
+
+  if(m_worldData.recordPath != nullptr &&
+     !m_replayWriter.open(m_worldData.recordPath, makeReplayHeader(m_worldData))) {
+    printf("[error] can't write replay %s\n", m_worldData.recordPath);
+    return false;
+  }
 
-  m_screenTexture = createTexture(m_worldData.windowWidth, m_worldData.windowHeight);
+  if(m_replayReader.isOpen() || m_replayWriter.isOpen()) {
+    overrideInput(true);
+  }
 
-  if(m_screenTexture == nullptr) {
+  if(m_worldData.messageStatsPath != nullptr && !openMessageStatsFile(m_worldData.messageStatsPath)) {
+    printf("[error] can't write message stats %s\n", m_worldData.messageStatsPath);
     return false;
   }
 
+  seedRandom(m_worldData.seed);
+
+  m_background = createSprite("sand");
+
+  m_screenTexture = nullptr;
+  if(!isHeadless()) {
+    m_screenTexture = createTexture(m_worldData.windowWidth, m_worldData.windowHeight);
+
+    if(m_screenTexture == nullptr) {
+      return false;
+    }
+  }
+
   return initMainPart();
 }
 
 bool CrimsonlandFramework::initMainPart() {
-  registerMethod<CrimsonlandFramework>(int(MessageType::PLAYER_DEAD),
-                                       &CrimsonlandFramework::onPlayerDead,
-                                       this);
+  m_playerDeadSubscription = subscribe<&CrimsonlandFramework::onPlayerDead>(this);
   m_playerDeadMessageReceived = false;
   m_playerDeadMessageProcessed = false;
 
@@ -80,8 +137,13 @@ bool CrimsonlandFramework::initMainPart() {
 
 bool CrimsonlandFramework::initECS() {
   m_registry = new Registry();
+  m_commands = new CommandBuffer(m_registry);
   m_context.registry = m_registry;
+  m_context.commands = m_commands;
+  m_context.jobs = m_jobs;
+  m_context.interpolationFactor = 1.0f;
   m_context.data = m_worldData;
+  if(!m_systemManager.addSystem(m_context, new TransformationHistorySystem(), "transformation_history_system")) return false;
   if(!m_systemManager.addSystem(m_context, new LevelSystem(), "level_system")) return false;
   if(!m_systemManager.addSystem(m_context, new PhysicsIntegrationSystem(), "integration_system")) return false;
   if(!m_systemManager.addSystem(m_context, new PhysicsCollisionSystem(), "collision_system")) return false;
@@ -94,25 +156,27 @@ bool CrimsonlandFramework::initECS() {
   if(!m_systemManager.addSystem(m_context, new ZombieSystem(), "zombie_system")) return false;
   if(!m_systemManager.addSystem(m_context, new ModelRenderingSystem(), "model_rendering_system")) return false;
 
-  m_uiSystem = new UIRenderingSystem();
+  m_uiSystem = new UIRenderingSystem(&m_systemManager);
   if(!m_uiSystem->init(m_context)) return false;
   return true;
 }
 
 bool CrimsonlandFramework::initPlants() {
 
+  Random& random = getRandom(RandomStream::Plants);
+
   int maximalCount = m_worldData.numPlants;
   for(int i = 0; i < maximalCount; ++i) {
-    int rnd = rand() % 100;
+    int rnd = random.nextInt(100);
 
     char name[32];
-    int plantNumber = rand() % 46 + 1;
+    int plantNumber = random.nextInt(46) + 1;
     sprintf(name, "tree_%d", plantNumber);
 
     Sprite* plantSprite = createSprite(name);
 
-    vec2 position(float(rand() % int(m_worldData.mapWidth * 1.25f)) - m_worldData.mapWidth * 0.75f,
-                  float(rand() % int(m_worldData.mapHeight * 1.25f)) - m_worldData.mapHeight * 0.75f
+    vec2 position(float(random.nextInt(uint32_t(m_worldData.mapWidth * 1.25f))) - m_worldData.mapWidth * 0.75f,
+                  float(random.nextInt(uint32_t(m_worldData.mapHeight * 1.25f))) - m_worldData.mapHeight * 0.75f
                   );
 
     if(rnd < 50) {
@@ -129,7 +193,11 @@ void CrimsonlandFramework::clearMainPart() {
 
   m_systemManager.clear();
   delete m_uiSystem;
+  delete m_commands;
   delete m_registry;
+
+  // NOTE(mizofix): queued messages refer to the entities of the deleted registry
+  clearMessageQueues();
 }
 
 void CrimsonlandFramework::clearPlants() {
@@ -146,7 +214,6 @@ void CrimsonlandFramework::clearPlants() {
 }
 
 bool CrimsonlandFramework::restartGame() {
-  clearSubscribers();
   clearMainPart();
   m_worldData.roundData.intermissionActivated = true;
   m_worldData.roundData.elapsedTime = 0.0f;
@@ -156,9 +223,46 @@ bool CrimsonlandFramework::restartGame() {
   return initMainPart();
 }
 
+bool CrimsonlandFramework::isHeadless() const {
+  return m_worldData.headlessTicks > 0;
+}
+
+bool CrimsonlandFramework::isBenchmark() const {
+  return m_worldData.collisionBenchmark || m_worldData.queryBenchmark || m_worldData.jobsBenchmark;
+}
+
+void CrimsonlandFramework::runBenchmarks() {
+  if(m_worldData.collisionBenchmark) {
+    runBroadphaseBenchmark(m_worldData.mapWidth, m_worldData.mapHeight, m_worldData.seed);
+    runNarrowphaseBenchmark(m_worldData.seed);
+  }
+
+  if(m_worldData.queryBenchmark) {
+    runQueryBenchmark(m_worldData.seed);
+  }
+
+  if(m_worldData.jobsBenchmark) {
+    std::size_t threadsCount = JobSystem::getDefaultWorkersCount() + 1;
+    if(m_worldData.threadsCount > 0) {
+      threadsCount = m_worldData.threadsCount;
+    }
+
+    runJobsBenchmark(m_worldData.seed, threadsCount);
+  }
+}
+
 bool CrimsonlandFramework::Tick() {
 
+  if(isHeadless()) {
+    return tickHeadless();
+  }
+
   if(!m_done) {
+    if(!processReplayFrame()) {
+      m_done = true;
+      return m_done;
+    }
+
     update();
     draw();
     drawToScreen();
@@ -168,7 +272,131 @@ bool CrimsonlandFramework::Tick() {
   return m_done;
 }
 
-void CrimsonlandFramework::onPlayerDead(Message message) {
+// NOTE(mizofix): one simulation tick per call, as fast as possible. Nothing is drawn
+bool CrimsonlandFramework::tickHeadless() {
+  if(m_headlessTick == 0) {
+    m_headlessStartTime = std::chrono::steady_clock::now();
+  }
+
+  if(!m_replayReader.isOpen()) {
+    applyScriptedInput();
+    m_deltaTime = m_simulationStep;
+  }
+
+  bool replayFinished = !processReplayFrame();
+  if(!replayFinished) {
+    m_lastTime += m_deltaTime;
+    update();
+    m_headlessTick++;
+  }
+
+  if(replayFinished || m_done || m_headlessTick >= m_worldData.headlessTicks) {
+    std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - m_headlessStartTime;
+    printf("headless: %u frames, %u ticks in %.3f s, %.1f ticks/s\n", m_headlessTick, m_simulationTicksCount,
+           elapsedTime.count(), double(m_simulationTicksCount) / elapsedTime.count());
+
+    return true;
+  }
+
+  return false;
+}
+
+// NOTE(mizofix): the player walks along a square (one side per two seconds), aims
+// around itself and shoots all the time. The game is restarted when it's lost
+void CrimsonlandFramework::applyScriptedInput() {
+  uint32_t side = (m_headlessTick / (m_worldData.simulationRate * 2)) % 4;
+  setKeyState(FRKey::RIGHT, side == 0);
+  setKeyState(FRKey::DOWN, side == 1);
+  setKeyState(FRKey::LEFT, side == 2);
+  setKeyState(FRKey::UP, side == 3);
+  setKeyState(FRKey::ACTION, m_playerDeadMessageReceived);
+
+  vec2 cursor = degToVec(real(m_headlessTick) * 3.0f) * 100.0f;
+  setCursorPos(int(cursor.x) + m_worldData.windowWidth / 2,
+               int(cursor.y) + m_worldData.windowHeight / 2);
+
+  setButtonState(FRMouseButton::LEFT, true);
+}
+
+// NOTE(mizofix): the input of the frame is read (or replayed) once before the update
+// and stays the same until the next one, so the recorded frame is exactly what the
+// game has seen. The replayed frame time replaces the measured one. Returns false
+// when the replay is over
+bool CrimsonlandFramework::processReplayFrame() {
+  ReplayFrame frame;
+
+  if(m_replayReader.isOpen()) {
+    if(!m_replayReader.readFrame(frame)) {
+      return false;
+    }
+
+    applyInput(frame);
+    m_deltaTime = frame.deltaTime;
+
+    if(frame.wheel != 0) {
+      MouseWheelMessage msg;
+      msg.y = frame.wheel;
+      notify(msg);
+    }
+  }
+  else if(m_replayWriter.isOpen()) {
+    frame = captureInput();
+    frame.deltaTime = m_deltaTime;
+    applyInput(frame);
+
+    if(!m_replayWriter.writeFrame(frame)) {
+      printf("[error] can't write replay %s\n", m_worldData.recordPath);
+      m_replayWriter.close();
+    }
+  }
+
+  return true;
+}
+
+ReplayFrame CrimsonlandFramework::captureInput() {
+  ReplayFrame frame = {};
+
+  // NOTE(mizofix): the scripted input of the headless mode is already set
+  if(!isHeadless()) {
+    overrideInput(false);
+  }
+
+  for(int key = 0; key < int(FRKey::COUNT); ++key) {
+    frame.keys |= isKeyPressed(FRKey(key)) ? uint16_t(1 << key) : 0;
+  }
+
+  for(int button = 0; button < int(FRMouseButton::COUNT); ++button) {
+    frame.buttons |= isButtonPressed(FRMouseButton(button)) ? uint8_t(1 << button) : 0;
+  }
+
+  int cursorX, cursorY;
+  getCursorPos(&cursorX, &cursorY);
+  frame.cursorX = int16_t(clamp(cursorX, INT16_MIN, INT16_MAX));
+  frame.cursorY = int16_t(clamp(cursorY, INT16_MIN, INT16_MAX));
+
+  frame.wheel = int8_t(clamp(m_frameMouseWheel, INT8_MIN, INT8_MAX));
+  m_frameMouseWheel = 0;
+
+  if(!isHeadless()) {
+    overrideInput(true);
+  }
+
+  return frame;
+}
+
+void CrimsonlandFramework::applyInput(const ReplayFrame& frame) {
+  for(int key = 0; key < int(FRKey::COUNT); ++key) {
+    setKeyState(FRKey(key), (frame.keys & (1 << key)) != 0);
+  }
+
+  for(int button = 0; button < int(FRMouseButton::COUNT); ++button) {
+    setButtonState(FRMouseButton(button), (frame.buttons & (1 << button)) != 0);
+  }
+
+  setCursorPos(frame.cursorX, frame.cursorY);
+}
+
+void CrimsonlandFramework::onPlayerDead(const PlayerDeadMessage& message) {
   m_playerDeadMessageReceived = true;
   m_playerDeadMessageProcessed = false;
 }
@@ -193,6 +421,8 @@ void CrimsonlandFramework::updateTimer() {
 
 
 void CrimsonlandFramework::update() {
+  PROFILE_ZONE("update");
+
   if(m_playerDeadMessageReceived) {
     m_deltaTime = 0.0f;
 
@@ -220,11 +450,41 @@ void CrimsonlandFramework::update() {
 
   }
 
-  m_systemManager.updateSystems(m_context, m_deltaTime);
+  if(m_playerDeadMessageReceived) {
+    m_systemManager.updateSystems(m_context, 0.0f);
+    m_context.interpolationFactor = 1.0f;
+  } else {
+    updateSimulation();
+  }
+
+  updateMessageFrameStats();
+
+  PROFILE_ZONE("ui", "update");
   m_uiSystem->update(m_context, m_deltaTime);
 }
 
+void CrimsonlandFramework::updateSimulation() {
+  m_simulationAccumulator += m_deltaTime;
+
+  int steps = 0;
+  while(m_simulationAccumulator >= m_simulationStep && steps < MAX_SIMULATION_STEPS) {
+    PROFILE_ZONE("simulation_tick");
+    m_systemManager.updateSystems(m_context, m_simulationStep);
+    m_simulationAccumulator -= m_simulationStep;
+    m_simulationTicksCount++;
+    steps++;
+  }
+
+  if(steps == MAX_SIMULATION_STEPS) {
+    m_simulationAccumulator = std::fmod(m_simulationAccumulator, m_simulationStep);
+  }
+
+  m_context.interpolationFactor = m_simulationAccumulator / m_simulationStep;
+}
+
 void CrimsonlandFramework::draw() {
+  PROFILE_ZONE("draw");
+
   setTextureAsTarget(m_screenTexture);
 
   drawTestBackground();
@@ -258,6 +518,7 @@ void CrimsonlandFramework::drawPlants(std::vector<std::pair<Sprite*, vec2>>& pla
 }
 
 void CrimsonlandFramework::drawToScreen() {
+  PROFILE_ZONE("draw_to_screen");
 
   setDefaultRenderTarget();
 
@@ -265,6 +526,15 @@ void CrimsonlandFramework::drawToScreen() {
 
   drawTexture(m_screenTexture, m_worldData.windowWidth, m_worldData.windowHeight, false);
 
+  drawPostEffect();
+
+  PROFILE_ZONE("ui", "draw");
+  m_uiSystem->draw(m_context);
+}
+
+void CrimsonlandFramework::drawPostEffect() {
+  PROFILE_ZONE("post_effect");
+
   bindTexture(m_screenTexture);
 
   GLint oldProgram;
@@ -293,8 +563,6 @@ void CrimsonlandFramework::drawToScreen() {
   glEnd();
 
   glUseProgram(oldProgram);
-
-  m_uiSystem->draw(m_context);
 }
 
 void CrimsonlandFramework::onMouseMove(int x, int y, int xrelative, int yrelative) {
@@ -302,20 +570,55 @@ void CrimsonlandFramework::onMouseMove(int x, int y, int xrelative, int yrelativ
 }
 
 void CrimsonlandFramework::onKeyPressed(FRKey k) {
+  if(k == FRKey::PROFILE) {
+    dumpProfile();
+  }
+  else if(k == FRKey::OVERLAY) {
+    m_uiSystem->toggleOverlay();
+  }
+}
 
+void CrimsonlandFramework::dumpProfile() {
+  const char* path = (m_worldData.profilePath != nullptr) ? m_worldData.profilePath : DEFAULT_PROFILE_PATH;
+  if(dumpProfilerTrace(path)) {
+    printf("profiler trace is written to %s\n", path);
+  } else {
+    printf("[error] can't write profiler trace to %s\n", path);
+  }
 }
 
 void CrimsonlandFramework::onMouseWheel(int y) {
-  Message msg;
-  msg.type = int(MessageType::ON_MOUSE_WHEEL);
-  msg.wheel.y = y;
+  // NOTE(mizofix): the replayed scroll is sent instead
+  if(m_replayReader.isOpen()) {
+    return;
+  }
+
+  m_frameMouseWheel = y;
+
+  MouseWheelMessage msg;
+  msg.y = y;
   notify(msg);
 
 }
 
 void CrimsonlandFramework::Close() {
+  if(m_worldData.profilePath != nullptr) {
+    dumpProfile();
+  }
+
+  if(!m_replayWriter.close()) {
+    printf("[error] can't write replay %s\n", m_worldData.recordPath);
+  }
+
+  if(!closeMessageStatsFile()) {
+    printf("[error] can't write message stats %s\n", m_worldData.messageStatsPath);
+  }
+
   clearMainPart();
 
   destroySprite(m_background);
   destroyTexture(m_screenTexture);
+
+  delete m_jobs;
+  m_jobs = nullptr;
 }
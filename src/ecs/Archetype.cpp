@@ -0,0 +1,152 @@
+#include "ecs/Archetype.h"
+#include "Assert.h"
+
+Archetype::Archetype(Bitset components,
+                     ComponentPool* entitiesPool,
+                     const ComponentPools& pools): m_components(components),
+                                                   m_size(0),
+                                                   m_entitiesPool(entitiesPool) {
+  Assert(entitiesPool != nullptr);
+
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    m_componentsInfo[id] = nullptr;
+    m_pools[id] = nullptr;
+
+    if(!components.isSet(id)) {
+      continue;
+    }
+
+    m_componentsInfo[id] = getComponentInfo(ComponentID(id));
+    m_pools[id] = pools[id];
+    Assert(m_componentsInfo[id] != nullptr && m_pools[id] != nullptr);
+  }
+}
+
+Archetype::~Archetype() {
+  while(!m_chunks.empty()) {
+    ArchetypeChunk& chunk = m_chunks.back();
+    for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+      if(m_componentsInfo[id] != nullptr) {
+        for(std::size_t i = 0; i < chunk.size; ++i) {
+          m_componentsInfo[id]->destroy(chunk.columns[id] + i * m_componentsInfo[id]->size);
+        }
+      }
+    }
+
+    releaseLastChunk();
+  }
+}
+
+ArchetypeRow Archetype::allocateRow(Entity entity) {
+  if(m_chunks.empty() || m_chunks.back().size == ARCHETYPE_CHUNK_CAPACITY) {
+    allocateChunk();
+  }
+
+  ArchetypeChunk& chunk = m_chunks.back();
+  chunk.entities[chunk.size] = entity;
+
+  ArchetypeRow row;
+  row.chunk = uint32_t(m_chunks.size() - 1);
+  row.index = uint32_t(chunk.size);
+
+  chunk.size++;
+  m_size++;
+
+  return row;
+}
+
+Entity Archetype::removeRow(ArchetypeRow row, bool destroyComponents) {
+  Assert(row.chunk < m_chunks.size() && row.index < m_chunks[row.chunk].size);
+
+  ArchetypeRow lastRow;
+  lastRow.chunk = uint32_t(m_chunks.size() - 1);
+  lastRow.index = uint32_t(m_chunks.back().size - 1);
+
+  bool isLastRow = (row.chunk == lastRow.chunk && row.index == lastRow.index);
+  Entity movedEntity = Constants::INVALID_ENTITY;
+
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    const ComponentInfo* info = m_componentsInfo[id];
+    if(info == nullptr) {
+      continue;
+    }
+
+    void* component = getComponent(row, ComponentID(id));
+    if(destroyComponents) {
+      info->destroy(component);
+    }
+
+    if(!isLastRow) {
+      info->move(component, getComponent(lastRow, ComponentID(id)));
+    }
+  }
+
+  if(!isLastRow) {
+    movedEntity = getEntity(lastRow);
+    m_chunks[row.chunk].entities[row.index] = movedEntity;
+  }
+
+  m_chunks.back().size--;
+  m_size--;
+
+  if(m_chunks.back().size == 0) {
+    releaseLastChunk();
+  }
+
+  return movedEntity;
+}
+
+void* Archetype::getComponent(ArchetypeRow row, ComponentID id) {
+  const ComponentInfo* info = m_componentsInfo[int(id)];
+  if(info == nullptr) {
+    return nullptr;
+  }
+
+  return m_chunks[row.chunk].columns[int(id)] + row.index * info->size;
+}
+
+Entity Archetype::getEntity(ArchetypeRow row) const {
+  return m_chunks[row.chunk].entities[row.index];
+}
+
+const Bitset& Archetype::getComponents() const {
+  return m_components;
+}
+
+std::size_t Archetype::getSize() const {
+  return m_size;
+}
+
+std::vector<ArchetypeChunk>& Archetype::getChunks() {
+  return m_chunks;
+}
+
+void Archetype::allocateChunk() {
+  ArchetypeChunk chunk;
+  chunk.size = 0;
+  chunk.entities = static_cast<Entity*>(m_entitiesPool->allocate());
+
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    chunk.columns[id] = nullptr;
+    if(m_pools[id] != nullptr) {
+      chunk.columns[id] = static_cast<uint8_t*>(m_pools[id]->allocate());
+    }
+  }
+
+  m_chunks.push_back(chunk);
+}
+
+void Archetype::releaseLastChunk() {
+  Assert(!m_chunks.empty());
+
+  ArchetypeChunk& chunk = m_chunks.back();
+  m_entitiesPool->release(chunk.entities);
+
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    if(m_pools[id] != nullptr) {
+      m_pools[id]->release(chunk.columns[id]);
+    }
+  }
+
+  m_chunks.pop_back();
+}
@@ -0,0 +1,128 @@
+#include "ecs/CommandBuffer.h"
+#include "ecs/Registry.h"
+#include "Assert.h"
+
+#include <algorithm>
+
+static thread_local uint32_t t_producer = 0;
+
+CommandBuffer::CommandBuffer(Registry* registry): m_registry(registry) {
+  Assert(registry != nullptr);
+}
+
+void CommandBuffer::setProducer(uint32_t producer) {
+  t_producer = producer;
+}
+
+uint32_t CommandBuffer::getProducer() {
+  return t_producer;
+}
+
+Entity CommandBuffer::createEntity(Bitset components, EntityInitFunction init) {
+  EntityCommand command;
+  command.type = EntityCommandType::CREATE;
+  command.entity = m_registry->reserveEntity();
+  command.components = components;
+  command.initFunction = -1;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(init) {
+    command.initFunction = int(m_initFunctions.size());
+    m_initFunctions.push_back(std::move(init));
+  }
+
+  command.producer = t_producer;
+  m_commands.push_back(command);
+
+  return command.entity;
+}
+
+void CommandBuffer::destroyEntity(Entity entity) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_destroyedEntities.push_back(entity);
+}
+
+void CommandBuffer::addComponent(Entity entity, ComponentID component) {
+  EntityCommand command;
+  command.type = EntityCommandType::ADD_COMPONENT;
+  command.entity = entity;
+  command.component = component;
+  command.initFunction = -1;
+
+  recordCommand(command);
+}
+
+void CommandBuffer::removeComponent(Entity entity, ComponentID component) {
+  EntityCommand command;
+  command.type = EntityCommandType::REMOVE_COMPONENT;
+  command.entity = entity;
+  command.component = component;
+  command.initFunction = -1;
+
+  recordCommand(command);
+}
+
+void CommandBuffer::recordCommand(EntityCommand& command) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  command.producer = t_producer;
+  m_commands.push_back(command);
+}
+
+void CommandBuffer::flush() {
+  // NOTE(mizofix): init functions and delete listeners may record new commands,
+  // so we work on our own copy of the buffers
+  std::vector<EntityCommand> commands;
+  std::vector<EntityInitFunction> initFunctions;
+  std::vector<Entity> destroyedEntities;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    commands.swap(m_commands);
+    initFunctions.swap(m_initFunctions);
+    destroyedEntities.swap(m_destroyedEntities);
+  }
+
+  // NOTE(mizofix): commands of one producer are already in the recorded order.
+  // Destructions don't need it, the registry sorts them anyway
+  std::stable_sort(commands.begin(), commands.end(),
+                   [](const EntityCommand& a, const EntityCommand& b) {
+                     return a.producer < b.producer;
+                   });
+
+  for(const EntityCommand& command: commands) {
+    switch(command.type) {
+    case EntityCommandType::CREATE: {
+      m_registry->createReservedEntity(command.entity, command.components);
+      if(command.initFunction >= 0) {
+        initFunctions[command.initFunction](m_registry, command.entity);
+      }
+    } break;
+
+    case EntityCommandType::ADD_COMPONENT: {
+      m_registry->addComponent(command.entity, command.component);
+    } break;
+
+    case EntityCommandType::REMOVE_COMPONENT: {
+      m_registry->removeComponent(command.entity, command.component);
+    } break;
+    }
+  }
+
+  m_registry->destroyEntities(destroyedEntities.data(), destroyedEntities.size());
+
+  // NOTE(mizofix): keep the memory of the buffers, if nothing was recorded meanwhile
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(m_commands.empty()) {
+    commands.clear();
+    m_commands.swap(commands);
+  }
+
+  if(m_destroyedEntities.empty()) {
+    destroyedEntities.clear();
+    m_destroyedEntities.swap(destroyedEntities);
+  }
+}
+
+bool CommandBuffer::isEmpty() const {
+  return m_commands.empty() && m_destroyedEntities.empty();
+}
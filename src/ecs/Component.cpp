@@ -1,11 +1,62 @@
-
 #include "ecs/Component.h"
+#include "Components.h"
 
-Component* componentFactory(ComponentID component) {
-  // TODO(mizofix): independent components binding
-  switch(component) {
-  default: break;
+#include <array>
+
+// NOTE(mizofix): hot components are moved around as raw bytes, keep them so
+static_assert(std::is_trivially_copyable<Transformation>::value, "Transformation must be trivially copyable");
+static_assert(std::is_trivially_copyable<Physics>::value, "Physics must be trivially copyable");
+static_assert(std::is_trivially_copyable<Attributes>::value, "Attributes must be trivially copyable");
+static_assert(std::is_trivially_copyable<Bullet>::value, "Bullet must be trivially copyable");
+
+using ComponentsInfo = std::array<ComponentInfo, int(ComponentID::COUNT)>;
+
+template <typename T>
+static void bindComponent(ComponentsInfo& componentsInfo) {
+  componentsInfo[int(T::ID)] = ComponentInfo::create<T>();
+}
+
+static ComponentsInfo buildComponentsInfo() {
+  ComponentsInfo result {};
+
+  bindComponent<Model>(result);
+  bindComponent<Transformation>(result);
+  bindComponent<Physics>(result);
+  bindComponent<Attributes>(result);
+  bindComponent<Player>(result);
+  bindComponent<Zombie>(result);
+  bindComponent<Bullet>(result);
+  bindComponent<Trail>(result);
+  bindComponent<WeaponBox>(result);
+
+  return result;
+}
+
+const ComponentInfo* getComponentInfo(ComponentID component) {
+  static const ComponentsInfo componentsInfo = buildComponentsInfo();
+
+  const ComponentInfo& info = componentsInfo[int(component)];
+  if(info.size == 0) {
+    return nullptr;
   }
 
-  return nullptr;
+  return &info;
+}
+
+const char* getComponentName(ComponentID component) {
+  switch(component) {
+  case ComponentID::Model: return "Model";
+  case ComponentID::Transformation: return "Transformation";
+  case ComponentID::Physics: return "Physics";
+  case ComponentID::Attributes: return "Attributes";
+  case ComponentID::Player: return "Player";
+  case ComponentID::Zombie: return "Zombie";
+  case ComponentID::Effect: return "Effect";
+  case ComponentID::Bullet: return "Bullet";
+  case ComponentID::Trail: return "Trail";
+  case ComponentID::Weapon: return "Weapon";
+  case ComponentID::Powerup: return "Powerup";
+  default: return "Unknown";
+  }
 }
+
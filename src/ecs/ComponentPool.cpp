@@ -0,0 +1,70 @@
+#include "ecs/ComponentPool.h"
+#include "Assert.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+ComponentPool::ComponentPool(std::size_t blockSize, std::size_t alignment,
+                             std::size_t blocksPerSlab): m_blocksPerSlab(blocksPerSlab),
+                                                         m_usedBlocks(0),
+                                                         m_freeBlocks(nullptr) {
+  Assert(blocksPerSlab > 0);
+
+  // NOTE(mizofix): a free block stores a pointer to the next one in itself
+  m_alignment = std::max(alignment, alignof(FreeBlock));
+  blockSize = std::max(blockSize, sizeof(FreeBlock));
+  m_blockSize = (blockSize + m_alignment - 1) / m_alignment * m_alignment;
+}
+
+ComponentPool::~ComponentPool() {
+  Assert(m_usedBlocks == 0);
+
+  for(void* slab: m_slabs) {
+    ::operator delete(slab, std::align_val_t(m_alignment));
+  }
+}
+
+void* ComponentPool::allocate() {
+  if(m_freeBlocks == nullptr) {
+    allocateSlab();
+  }
+
+  FreeBlock* block = m_freeBlocks;
+  m_freeBlocks = block->next;
+  m_usedBlocks++;
+
+  return block;
+}
+
+void ComponentPool::release(void* block) {
+  Assert(block != nullptr && m_usedBlocks > 0);
+
+  FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+  freeBlock->next = m_freeBlocks;
+  m_freeBlocks = freeBlock;
+  m_usedBlocks--;
+}
+
+ComponentPoolStats ComponentPool::getStats() const {
+  ComponentPoolStats stats;
+  stats.blockSize = m_blockSize;
+  stats.slabs = m_slabs.size();
+  stats.blocks = m_slabs.size() * m_blocksPerSlab;
+  stats.usedBlocks = m_usedBlocks;
+
+  return stats;
+}
+
+void ComponentPool::allocateSlab() {
+  uint8_t* slab = static_cast<uint8_t*>(::operator new(m_blockSize * m_blocksPerSlab,
+                                                       std::align_val_t(m_alignment)));
+  m_slabs.push_back(slab);
+
+  // NOTE(mizofix): pushed in reverse, so blocks are handed out in the address order
+  for(std::size_t i = m_blocksPerSlab; i > 0; --i) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * m_blockSize);
+    block->next = m_freeBlocks;
+    m_freeBlocks = block;
+  }
+}
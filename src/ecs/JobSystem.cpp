@@ -0,0 +1,160 @@
+#include "ecs/JobSystem.h"
+#include "ecs/CommandBuffer.h"
+#include "Assert.h"
+
+static thread_local const JobSystem* t_jobSystem = nullptr;
+static thread_local std::size_t t_queueIndex = 0;
+
+JobSystem::JobSystem(std::size_t workersCount): m_queuedJobs(0), m_stop(false) {
+  for(std::size_t i = 0; i < workersCount + 1; ++i) {
+    m_queues.push_back(new JobQueue());
+  }
+
+  for(std::size_t i = 0; i < workersCount; ++i) {
+    m_workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stop = true;
+  }
+
+  m_wakeCondition.notify_all();
+  for(std::thread& worker: m_workers) {
+    worker.join();
+  }
+
+  for(JobQueue* queue: m_queues) {
+    Assert(queue->jobs.empty());
+    delete queue;
+  }
+}
+
+void JobSystem::run(JobFunction function, JobCounter* counter) {
+  Assert(counter != nullptr);
+  counter->m_count.fetch_add(1, std::memory_order_relaxed);
+
+  Job job;
+  job.function = std::move(function);
+  job.counter = counter;
+  job.producer = CommandBuffer::getProducer();
+  job.messageBatch = getMessageBatch();
+
+  JobQueue* queue = m_queues[getQueueIndex()];
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->jobs.push_back(std::move(job));
+  }
+
+  m_queuedJobs.fetch_add(1, std::memory_order_release);
+
+  // NOTE(mizofix): a worker checks the number of queued jobs under the mutex
+  // before it sleeps, so taking the mutex here keeps the wake up from being lost
+  if(!m_workers.empty()) {
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    m_wakeCondition.notify_one();
+  }
+}
+
+void JobSystem::wait(JobCounter* counter) {
+  while(!counter->isDone()) {
+    if(!tryRunJob()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+std::size_t JobSystem::getWorkersCount() const {
+  return m_workers.size();
+}
+
+std::size_t JobSystem::getDefaultWorkersCount() {
+  std::size_t threadsCount = std::thread::hardware_concurrency();
+  return (threadsCount > 1) ? threadsCount - 1 : 0;
+}
+
+void JobSystem::workerLoop(std::size_t queueIndex) {
+  t_jobSystem = this;
+  t_queueIndex = queueIndex;
+
+  while(true) {
+    if(tryRunJob()) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wakeCondition.wait(lock, [this]() {
+      return m_stop || m_queuedJobs.load(std::memory_order_acquire) > 0;
+    });
+
+    if(m_stop) {
+      return;
+    }
+  }
+}
+
+bool JobSystem::tryRunJob() {
+  if(m_queuedJobs.load(std::memory_order_acquire) == 0) {
+    return false;
+  }
+
+  std::size_t queueIndex = getQueueIndex();
+
+  Job job;
+  if(popJob(queueIndex, job) || stealJob(queueIndex, job)) {
+    m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    runJob(job);
+    return true;
+  }
+
+  return false;
+}
+
+bool JobSystem::popJob(std::size_t queueIndex, Job& job) {
+  JobQueue* queue = m_queues[queueIndex];
+
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  if(queue->jobs.empty()) {
+    return false;
+  }
+
+  job = std::move(queue->jobs.back());
+  queue->jobs.pop_back();
+  return true;
+}
+
+bool JobSystem::stealJob(std::size_t queueIndex, Job& job) {
+  for(std::size_t i = 1; i < m_queues.size(); ++i) {
+    JobQueue* queue = m_queues[(queueIndex + i) % m_queues.size()];
+
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if(!queue->jobs.empty()) {
+      job = std::move(queue->jobs.front());
+      queue->jobs.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JobSystem::runJob(Job& job) {
+  // NOTE(mizofix): the thread may run the job in the middle of its own one (see
+  // wait()), so its producer and batch are restored afterwards
+  uint32_t previousProducer = CommandBuffer::getProducer();
+  uint32_t previousBatch = getMessageBatch();
+  CommandBuffer::setProducer(job.producer);
+  setMessageBatch(job.messageBatch);
+
+  job.function();
+
+  CommandBuffer::setProducer(previousProducer);
+  setMessageBatch(previousBatch);
+  job.counter->m_count.fetch_sub(1, std::memory_order_release);
+}
+
+std::size_t JobSystem::getQueueIndex() const {
+  return (t_jobSystem == this) ? t_queueIndex : 0;
+}
@@ -1,128 +1,340 @@
-
 #include "ecs/Registry.h"
 #include "Message.h"
 #include "Assert.h"
 
-Registry::Registry(): m_newEntityID(0) { }
+#include <algorithm>
+
+Registry::Registry() {
+  m_entitiesPool = new ComponentPool(sizeof(Entity) * ARCHETYPE_CHUNK_CAPACITY, alignof(Entity));
+
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    const ComponentInfo* info = getComponentInfo(ComponentID(id));
+    m_componentPools[id] = nullptr;
+
+    if(info != nullptr) {
+      m_componentPools[id] = new ComponentPool(info->size * ARCHETYPE_CHUNK_CAPACITY, info->alignment);
+    }
+  }
+}
 
 Registry::~Registry() {
   clear();
+
+  for(ComponentPool* pool: m_componentPools) {
+    delete pool;
+  }
+
+  delete m_entitiesPool;
 }
 
 Entity Registry::createEntity(Bitset components) {
-  Entity newEntity = m_newEntityID++;
-  m_entities[newEntity] = Components();
-  m_entities[newEntity].second.fill(nullptr);
-
-  for(ComponentID component = ComponentID(0);
-      component < ComponentID::COUNT;
-      component = ComponentID(int(component) + 1)) {
-
-    if(components.isSet(int(component))) {
-      m_entities[newEntity].second[int(component)] = componentFactory(component);
-      if(m_entities[newEntity].second[int(component)] != nullptr) {
-        m_entities[newEntity].first.setBit(int(component ));
-      }
-    }
-  }
+  uint32_t index = allocateSlot();
+  Entity newEntity = makeEntity(index, m_slots[index].generation);
 
-  Message msg(int(MessageType::ECS_ENTITY_CREATED));
-  msg.entity_info.entity = newEntity;
-  notify(msg);
+  placeEntity(newEntity, components);
 
   return newEntity;
 }
 
 void Registry::destroyEntity(Entity entity) {
-  auto entityIt = m_entities.find(entity);
-  if(entityIt != m_entities.end()) {
-    Message msg(int(MessageType::ECS_ENTITY_DELETE));
-    msg.entity_info.entity = entity;
-    msg.entity_info.registry = this;
-    notify(msg);
-
-    for(Component* component : entityIt->second.second) {
-      if(component != nullptr) {
-        delete component;
-      }
+  destroyEntities(&entity, 1);
+}
+
+void Registry::destroyEntities(const Entity* entities, std::size_t count) {
+  std::vector<Entity> aliveEntities;
+  aliveEntities.reserve(count);
+  for(std::size_t i = 0; i < count; ++i) {
+    if(getLocation(entities[i]) != nullptr) {
+      aliveEntities.push_back(entities[i]);
     }
+  }
 
-    m_entities.erase(entityIt);
+  std::sort(aliveEntities.begin(), aliveEntities.end());
+  aliveEntities.erase(std::unique(aliveEntities.begin(), aliveEntities.end()), aliveEntities.end());
+
+  if(aliveEntities.empty()) {
+    return;
+  }
+
+  EntitiesDeleteMessage batchMsg;
+  batchMsg.registry = this;
+  batchMsg.entities = aliveEntities.data();
+  batchMsg.count = uint32_t(aliveEntities.size());
+  notify(batchMsg);
+
+  if(hasSubscribers(MessageType::ECS_ENTITY_DELETE)) {
+    for(Entity entity: aliveEntities) {
+      EntityDeleteMessage msg;
+      msg.registry = this;
+      msg.entity = entity;
+      notify(msg);
+    }
+  }
+
+  for(Entity entity: aliveEntities) {
+    // NOTE(mizofix): listeners might have destroyed it already
+    if(getLocation(entity) != nullptr) {
+      releaseSlot(entity);
+    }
   }
 }
 
-bool Registry::isEntityExists(Entity entity) const {
-  return m_entities.find(entity) != m_entities.end();
+Entity Registry::reserveEntity() {
+  uint32_t index = allocateSlot();
+  m_slots[index].reserved = true;
+
+  return makeEntity(index, m_slots[index].generation);
 }
 
-void Registry::addComponent(Entity entity, ComponentID component) {
-  auto entityIt = m_entities.find(entity);
-  if(entityIt != m_entities.end()) {
-    if(!entityIt->second.first.isSet(int(component))) {
-      Component* newComponent= componentFactory(component);
-      if(newComponent != nullptr) {
-        entityIt->second.second[int(component)] = newComponent;
-        entityIt->second.first.setBit(int(component));
-      }
+void Registry::createReservedEntity(Entity entity, Bitset components) {
+  uint32_t index = getEntityIndex(entity);
+  Assert(index < m_slots.size() && m_slots[index].reserved);
+  Assert(m_slots[index].generation == getEntityGeneration(entity));
+
+  m_slots[index].reserved = false;
+  placeEntity(entity, components);
+}
+
+uint32_t Registry::allocateSlot() {
+  uint32_t index = 0;
+  if(m_freeSlots.size() > ENTITY_MIN_FREE_SLOTS) {
+    index = m_freeSlots.front();
+    m_freeSlots.pop_front();
+  } else {
+    index = uint32_t(m_slots.size());
+    Assert(index < Constants::ENTITY_INDEX_MASK);
+
+    EntitySlot slot;
+    slot.location.archetype = nullptr;
+    slot.generation = 0;
+    slot.reserved = false;
+    m_slots.push_back(slot);
+  }
+
+  return index;
+}
+
+void Registry::placeEntity(Entity newEntity, Bitset components) {
+  uint32_t index = getEntityIndex(newEntity);
+
+  Bitset boundComponents;
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    if(components.isSet(id) && getComponentInfo(ComponentID(id)) != nullptr) {
+      boundComponents.setBit(id);
+    }
+  }
+
+  EntityLocation location;
+  location.archetype = getArchetype(boundComponents);
+  location.row = location.archetype->allocateRow(newEntity);
+
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    if(boundComponents.isSet(id)) {
+      getComponentInfo(ComponentID(id))->construct(location.archetype->getComponent(location.row,
+                                                                                    ComponentID(id)));
     }
   }
+
+  m_slots[index].location = location;
+
+  EntityCreatedMessage msg;
+  msg.registry = this;
+  msg.entity = newEntity;
+  notify(msg);
 }
 
-void Registry::addComponent(Entity entity, Component* component) {
-  Assert(component != nullptr);
+void Registry::releaseSlot(Entity entity) {
+  // NOTE(mizofix): listeners of delete messages are free to create entities, so
+  // the slot is taken only after the notifications
+  EntitySlot& slot = m_slots[getEntityIndex(entity)];
+  EntityLocation location = slot.location;
+
+  slot.location.archetype = nullptr;
+  slot.generation = (slot.generation + 1) & Constants::ENTITY_GENERATION_MASK;
+  m_freeSlots.push_back(getEntityIndex(entity));
+
+  Entity movedEntity = location.archetype->removeRow(location.row, true);
+  if(movedEntity != Constants::INVALID_ENTITY) {
+    m_slots[getEntityIndex(movedEntity)].location.row = location.row;
+  }
+}
 
-  auto entityIt = m_entities.find(entity);
-  if(entityIt != m_entities.end()) {
-    ComponentID id = component->getID();
+bool Registry::isEntityExists(Entity entity) const {
+  return getLocation(entity) != nullptr;
+}
+
+std::size_t Registry::getEntitySlotsCount() const {
+  return m_slots.size();
+}
+
+void Registry::addComponent(Entity entity, ComponentID component) {
+  EntityLocation* location = getLocation(entity);
+  if(location != nullptr) {
+    const ComponentInfo* info = getComponentInfo(component);
 
-    if(!entityIt->second.first.isSet(int(id))) {
-      entityIt->second.second[int(id)] = component;
-      entityIt->second.first.setBit(int(id));
+    if(info != nullptr && !location->archetype->getComponents().isSet(int(component))) {
+      Bitset newComponents = location->archetype->getComponents();
+      newComponents.setBit(int(component));
+
+      changeArchetype(entity, *location, newComponents);
+      info->construct(location->archetype->getComponent(location->row, component));
     }
   }
 }
 
 void Registry::removeComponent(Entity entity, ComponentID id) {
-  auto entityIt = m_entities.find(entity);
-  if(entityIt != m_entities.end()) {
-    if(entityIt->second.first.isSet(int(id))) {
-      Assert(entityIt->second.second[int(id)] != nullptr);
+  EntityLocation* location = getLocation(entity);
+  if(location != nullptr && location->archetype->getComponents().isSet(int(id))) {
+    Bitset newComponents = location->archetype->getComponents();
+    newComponents.resetBit(int(id));
 
-      entityIt->second.first.setBit(int(id));
-      delete entityIt->second.second[int(id)];
-    }
+    changeArchetype(entity, *location, newComponents);
   }
 }
 
 bool Registry::hasComponent(Entity entity, ComponentID id) {
-  auto entityIt = m_entities.find(entity);
-  if(entityIt == m_entities.end()) {
+  EntityLocation* location = getLocation(entity);
+  if(location == nullptr) {
     return false;
   }
 
-  return entityIt->second.first.isSet(int(id));
+  return location->archetype->getComponents().isSet(int(id));
 }
 
-EntitiesContainer Registry::findEntities(Bitfield components) {
-  EntitiesContainer result;
-  for(auto entityPair: m_entities) {
-    if(entityPair.second.first.isSetBits(components)) {
-      result.push_back(entityPair.first);
+bool Registry::hasComponents(Entity entity, const Bitset& components) const {
+  const EntityLocation* location = getLocation(entity);
+  if(location == nullptr) {
+    return false;
+  }
+
+  return location->archetype->getComponents().isSetBits(components);
+}
+
+Query* Registry::createQuery(const Bitset& components) {
+  for(Query* query: m_queries) {
+    if(query->getComponents() == components) {
+      return query;
     }
   }
 
+  Query* query = new Query(components);
+  std::size_t matchesCount = matchArchetypes(components, m_archetypeMatches);
+  for(std::size_t i = 0; i < matchesCount; ++i) {
+    query->m_archetypes.push_back(m_archetypes[m_archetypeMatches[i]]);
+  }
+
+  m_queries.push_back(query);
+  return query;
+}
+
+EntitiesContainer Registry::findEntities(const Bitset& components) {
+  EntitiesContainer result;
+  forEachChunk(components, [&result](Archetype& archetype, ArchetypeChunk& chunk) {
+    for(std::size_t i = 0; i < chunk.size; ++i) {
+      result.push_back(chunk.entities[i]);
+    }
+  });
+
   return result;
 }
 
-void Registry::clear() {
-  for(auto entityPair : m_entities) {
-    for(auto component : entityPair.second.second) {
-      if(component != nullptr) {
-        delete component;
-      }
+ComponentPoolStats Registry::getComponentPoolStats(ComponentID id) const {
+  const ComponentPool* pool = m_componentPools[int(id)];
+  if(pool == nullptr) {
+    return ComponentPoolStats {};
+  }
+
+  return pool->getStats();
+}
+
+ComponentPoolStats Registry::getEntitiesPoolStats() const {
+  return m_entitiesPool->getStats();
+}
+
+std::size_t Registry::getComponentsCount(ComponentID id) const {
+  std::size_t count = 0;
+  for(const Archetype* archetype: m_archetypes) {
+    if(archetype->getComponents().isSet(int(id))) {
+      count += archetype->getSize();
+    }
+  }
+
+  return count;
+}
+
+Archetype* Registry::getArchetype(Bitset components) {
+  auto archetypeIt = m_archetypesMap.find(components);
+  if(archetypeIt != m_archetypesMap.end()) {
+    return archetypeIt->second;
+  }
+
+  Archetype* archetype = new Archetype(components, m_entitiesPool, m_componentPools);
+  m_archetypes.push_back(archetype);
+  m_archetypeSignatures.push_back(components);
+  m_archetypesMap[components] = archetype;
+
+  for(Query* query: m_queries) {
+    if(query->isMatching(archetype)) {
+      query->m_archetypes.push_back(archetype);
+    }
+  }
+
+  return archetype;
+}
+
+std::size_t Registry::matchArchetypes(const Bitset& components,
+                                      std::vector<uint32_t>& matches) const {
+  matches.resize(m_archetypeSignatures.size());
+
+  return matchSignatures(m_archetypeSignatures.data(), m_archetypeSignatures.size(),
+                         components, matches.data());
+}
+
+void Registry::changeArchetype(Entity entity, EntityLocation& location, Bitset newComponents) {
+  Archetype* oldArchetype = location.archetype;
+  ArchetypeRow oldRow = location.row;
+
+  Archetype* newArchetype = getArchetype(newComponents);
+  ArchetypeRow newRow = newArchetype->allocateRow(entity);
+
+  for(int id = 0; id < int(ComponentID::COUNT); ++id) {
+    if(!oldArchetype->getComponents().isSet(id)) {
+      continue;
+    }
+
+    const ComponentInfo* info = getComponentInfo(ComponentID(id));
+    void* component = oldArchetype->getComponent(oldRow, ComponentID(id));
+
+    if(newComponents.isSet(id)) {
+      info->move(newArchetype->getComponent(newRow, ComponentID(id)), component);
+    } else {
+      info->destroy(component);
     }
   }
 
-  m_newEntityID = 0;
-  m_entities.clear();
+  location.archetype = newArchetype;
+  location.row = newRow;
+
+  Entity movedEntity = oldArchetype->removeRow(oldRow, false);
+  if(movedEntity != Constants::INVALID_ENTITY) {
+    m_slots[getEntityIndex(movedEntity)].location.row = oldRow;
+  }
+}
+
+void Registry::clear() {
+  for(Query* query: m_queries) {
+    delete query;
+  }
+
+  for(Archetype* archetype: m_archetypes) {
+    delete archetype;
+  }
+
+  m_slots.clear();
+  m_freeSlots.clear();
+  m_archetypes.clear();
+  m_archetypesMap.clear();
+  m_archetypeSignatures.clear();
+  m_archetypeMatches.clear();
+  m_queries.clear();
 }
@@ -0,0 +1,90 @@
+#include "ecs/SystemScheduler.h"
+#include "Assert.h"
+#include "Profiler.h"
+
+SystemScheduler::SystemScheduler(): m_context(nullptr), m_deltaTime(0.0f) {
+
+}
+
+void SystemScheduler::build(const std::vector<System*>& systems) {
+  m_nodes.clear();
+  m_nodes.resize(systems.size());
+  m_remainingDependencies.reset(new std::atomic<std::size_t>[systems.size()]);
+
+  for(std::size_t i = 0; i < systems.size(); ++i) {
+    SystemNode& node = m_nodes[i];
+    node.system = systems[i];
+    node.dependenciesCount = 0;
+    node.updateTime = 0;
+
+    for(std::size_t j = 0; j < i; ++j) {
+      if(systems[j]->getAccess().isConflicting(systems[i]->getAccess())) {
+        m_nodes[j].dependents.push_back(i);
+        node.dependenciesCount++;
+      }
+    }
+  }
+}
+
+void SystemScheduler::update(ECSContext& context, real deltaTime) {
+  JobSystem* jobs = context.jobs;
+
+  if(jobs->getWorkersCount() == 0) {
+    for(std::size_t i = 0; i < m_nodes.size(); ++i) {
+      updateNode(i, context, deltaTime);
+    }
+
+    return;
+  }
+
+  m_context = &context;
+  m_deltaTime = deltaTime;
+
+  for(std::size_t i = 0; i < m_nodes.size(); ++i) {
+    m_remainingDependencies[i].store(m_nodes[i].dependenciesCount, std::memory_order_relaxed);
+  }
+
+  JobCounter counter;
+  for(std::size_t i = 0; i < m_nodes.size(); ++i) {
+    if(m_nodes[i].dependenciesCount == 0) {
+      jobs->run([this, i, &counter]() { runNode(i, &counter); }, &counter);
+    }
+  }
+
+  // NOTE(mizofix): the main thread runs systems as well, until all of them are done
+  jobs->wait(&counter);
+
+  m_context = nullptr;
+}
+
+uint64_t SystemScheduler::getUpdateTime(std::size_t system) const {
+  Assert(system < m_nodes.size());
+  return m_nodes[system].updateTime;
+}
+
+void SystemScheduler::updateNode(std::size_t nodeIndex, ECSContext& context, real deltaTime) {
+  SystemNode& node = m_nodes[nodeIndex];
+  uint64_t startTime = getProfilerTime();
+
+  CommandBuffer::setProducer(uint32_t(nodeIndex));
+  node.system->update(context, deltaTime);
+
+  uint64_t endTime = getProfilerTime();
+  recordProfilerEvent(node.system->getProfilerName(), "update", startTime, endTime);
+  node.updateTime = endTime - startTime;
+}
+
+void SystemScheduler::runNode(std::size_t nodeIndex, JobCounter* counter) {
+  SystemNode& node = m_nodes[nodeIndex];
+  updateNode(nodeIndex, *m_context, m_deltaTime);
+
+  // NOTE(mizofix): the dependent is run before this job is done, so the counter
+  // can't reach zero meanwhile
+  for(std::size_t dependent: node.dependents) {
+    std::size_t remaining = m_remainingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel);
+    Assert(remaining > 0);
+    if(remaining == 1) {
+      m_context->jobs->run([this, dependent, counter]() { runNode(dependent, counter); }, counter);
+    }
+  }
+}